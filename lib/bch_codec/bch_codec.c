@@ -27,6 +27,10 @@
  * the given m (Galois field order), t (error correction capability) and
  * (optional) primitive polynomial parameters.
  *
+ * Several users of the same code can share its lookup tables instead: build
+ * them once with init_bch_tables and give every user its own workspace from
+ * init_bch_workspace. A workspace is not reentrant, the tables are read-only.
+ *
  * Call encode_bch to compute and store ecc parity bytes to a given buffer.
  * Call decode_bch to detect and locate errors in received data.
  *
@@ -788,6 +792,9 @@ static struct gf_poly* gf_poly_gcd(struct bch_control* bch, struct gf_poly* a, s
         b = a;
         a = tmp;
     }
+    /* a nonzero constant remainder means a and b are coprime */
+    if (b->c[0])
+        a = b;
 
     dbg("%s\n", gf_poly_str(a));
 
@@ -859,7 +866,7 @@ static void factor_polynomial(struct bch_control* bch, int k, struct gf_poly* f,
         /* compute g = gcd(f, tk) (destructive operation) */
         gf_poly_copy(f2, f);
         gcd = gf_poly_gcd(bch, f2, tk);
-        if (gcd->deg < f->deg) {
+        if (gcd->deg > 0 && gcd->deg < f->deg) {
             /* compute h=f/gcd(f,tk); this will modify f and q */
             gf_poly_div(bch, f, gcd, q);
             /* store g and h in-place (clobbering f) */
@@ -908,6 +915,125 @@ static int find_poly_roots(struct bch_control* bch, unsigned int k, struct gf_po
     return cnt;
 }
 
+/*
+ * log of the square root of a nonzero element, n is odd
+ */
+inline static unsigned int a_log_sqrt(struct bch_control* bch, unsigned int x)
+{
+    const unsigned int l = a_log(bch, x);
+    return (l & 1) ? (l + GF_N(bch)) / 2 : l / 2;
+}
+
+/*
+ * roots X1, X2 of X^2+s1X+s2 from the table of y^2+y+c, using X=s1.y
+ */
+static int find_closed_form_deg2_roots(struct bch_control* bch, unsigned int s1, unsigned int s2, unsigned int* roots)
+{
+    unsigned int y;
+
+    if (!s1)
+        /* double root */
+        return -1;
+    y = bch->tables->deg2_tab[gf_div(bch, s2, gf_sqr(bch, s1))];
+    if (!y)
+        return -1;
+    roots[0] = a_log(bch, gf_mul(bch, s1, y));
+    roots[1] = a_log(bch, gf_mul(bch, s1, y ^ 1));
+    return 2;
+}
+
+/*
+ * roots of X^3+s1X^2+s2X+s3 (s3!=0), X=Z+s1 gives Z^3+pZ+q and Z=sqrt(p).W gives W^3+W+q/p^(3/2), whose table holds one root w,
+ * the other two solve W^2+wW+w^2+1
+ */
+static int find_closed_form_deg3_roots(struct bch_control* bch, unsigned int s1, unsigned int s2, unsigned int s3, unsigned int* roots)
+{
+    const unsigned int n = GF_N(bch);
+    unsigned int p, q, w, y, l, i, z[3];
+
+    p = gf_sqr(bch, s1) ^ s2;
+    q = gf_mul(bch, s1, s2) ^ s3;
+    if (!q)
+        /* Z=0 and a double root */
+        return -1;
+    if (!p) {
+        /* Z^3=q has 3 distinct roots only if 3 divides n and log(q) */
+        l = a_log(bch, q);
+        if ((n % 3) || (l % 3))
+            return -1;
+        for (i = 0; i < 3; i++)
+            z[i] = a_pow(bch, l / 3 + i * (n / 3));
+    } else {
+        l = a_log_sqrt(bch, p);
+        w = bch->tables->deg3_tab[a_pow(bch, a_log(bch, q) + 3 * (n - l))];
+        if (!w)
+            return -1;
+        y = bch->tables->deg2_tab[gf_div(bch, gf_sqr(bch, w) ^ 1, gf_sqr(bch, w))];
+        if (!y)
+            return -1;
+        z[0] = gf_mul(bch, a_pow(bch, l), w);
+        z[1] = gf_mul(bch, z[0], y);
+        z[2] = gf_mul(bch, z[0], y ^ 1);
+    }
+    for (i = 0; i < 3; i++) {
+        if (z[i] == s1)
+            return -1;
+        roots[i] = a_log(bch, z[i] ^ s1);
+    }
+    return 3;
+}
+
+/*
+ * error locations of up to t <= 3 errors straight from the syndromes: Peterson's solution of the Newton identities for the error
+ * locator coefficients, then table lookups for its roots. Any solution with distinct roots is the unique pattern of at most t errors
+ * with these syndromes, so the outcome is the one of Berlekamp-Massey and find_poly_roots
+ */
+static int find_closed_form_roots(struct bch_control* bch, const unsigned int* syn, unsigned int* roots)
+{
+    const unsigned int t = GF_T(bch);
+    const unsigned int s1 = syn[0];
+    const unsigned int s3 = (t > 1) ? syn[2] : 0;
+    const unsigned int s5 = (t > 2) ? syn[4] : 0;
+    unsigned int sigma1, sigma2, sigma3, s1_3, d;
+
+    if (t == 1) {
+        if (!s1)
+            return 0;
+        roots[0] = a_log(bch, s1);
+        return 1;
+    }
+    if (t == 2) {
+        if (!s1)
+            return s3 ? -1 : 0;
+        sigma1 = s1;
+        sigma2 = gf_div(bch, s3 ^ gf_mul(bch, gf_sqr(bch, s1), s1), s1);
+        sigma3 = 0;
+    } else {
+        s1_3 = gf_mul(bch, gf_sqr(bch, s1), s1);
+        d = s1_3 ^ s3;
+        if (!d) {
+            /* no 2 or 3 error pattern, a single error needs s5=s1^5 */
+            if (!s1)
+                return s5 ? -1 : 0;
+            if (s5 != gf_mul(bch, s1_3, gf_sqr(bch, s1)))
+                return -1;
+            sigma1 = s1;
+            sigma2 = 0;
+            sigma3 = 0;
+        } else {
+            sigma1 = s1;
+            sigma2 = gf_div(bch, gf_mul(bch, gf_sqr(bch, s1), s3) ^ s5, d);
+            sigma3 = d ^ gf_mul(bch, s1, sigma2);
+        }
+    }
+    if (sigma3)
+        return find_closed_form_deg3_roots(bch, sigma1, sigma2, sigma3, roots);
+    if (sigma2)
+        return find_closed_form_deg2_roots(bch, sigma1, sigma2, roots);
+    roots[0] = a_log(bch, sigma1);
+    return 1;
+}
+
 #if defined(USE_CHIEN_SEARCH)
 /*
  * exhaustive root search (Chien) implementation - not used, included only for
@@ -1023,11 +1149,20 @@ int decode_bch(struct bch_control* bch, const uint8_t* data, unsigned int len, c
         syn = bch->syn;
     }
 
-    err = compute_error_locator_polynomial(bch, syn);
-    if (err > 0) {
-        nroots = find_poly_roots(bch, 1, bch->elp, errloc);
-        if (err != nroots)
-            err = -1;
+    if (bch->closed_form) {
+        err = find_closed_form_roots(bch, syn, errloc);
+    } else {
+        err = compute_error_locator_polynomial(bch, syn);
+        if (err > 4 && bch->root_search) {
+            /* past the ad hoc degrees of find_poly_roots */
+            nroots = bch->root_search(bch->root_search_context, bch->elp->c, bch->elp->deg, errloc);
+            if (err != nroots)
+                err = -1;
+        } else if (err > 0) {
+            nroots = find_poly_roots(bch, 1, bch->elp, errloc);
+            if (err != nroots)
+                err = -1;
+        }
     }
     if (err > 0) {
         /* post-process raw error locations for easier correction */
@@ -1146,6 +1281,32 @@ static int build_deg2_base(struct bch_control* bch)
     return remaining ? -1 : 0;
 }
 
+/*
+ * build the root tables of the closed form decoders, y is a root of y^2+y+c for c=y^2+y and w of w^3+w+c for c=w^3+w
+ */
+static int build_closed_form_tables(struct bch_control* bch, uint16_t* deg2_tab, uint16_t* deg3_tab)
+{
+    unsigned int x, c;
+    uint8_t* roots = (uint8_t*)calloc(GF_N(bch) + 1, 1);
+
+    if (roots == NULL)
+        return -1;
+    memset(deg2_tab, 0, (GF_N(bch) + 1) * sizeof(*deg2_tab));
+    memset(deg3_tab, 0, (GF_N(bch) + 1) * sizeof(*deg3_tab));
+    for (x = 2; x <= GF_N(bch); x++)
+        deg2_tab[gf_sqr(bch, x) ^ x] = x;
+    /* keep w^3+w+c only if it splits into 3 distinct roots, c=0 has the double root 1 */
+    for (x = 0; x <= GF_N(bch); x++)
+        roots[gf_mul(bch, gf_sqr(bch, x), x) ^ x]++;
+    for (x = 2; x <= GF_N(bch); x++) {
+        c = gf_mul(bch, gf_sqr(bch, x), x) ^ x;
+        if (roots[c] == 3)
+            deg3_tab[c] = x;
+    }
+    free(roots);
+    return 0;
+}
+
 static void* bch_alloc(size_t size, int* err)
 {
     void* ptr;
@@ -1224,32 +1385,29 @@ finish:
 }
 
 /**
- * init_bch - initialize a BCH encoder/decoder
+ * init_bch_tables - build the read-only lookup tables of a BCH code
  * @m:          Galois field order, should be in the range 5-15
  * @t:          maximum error correction capability, in bits
  * @prim_poly:  user-provided primitive polynomial (or 0 to use default)
  *
  * Returns:
- *  a newly allocated BCH control structure if successful, NULL otherwise
+ *  newly allocated tables if successful, NULL otherwise
  *
  * This initialization can take some time, as lookup tables are built for fast
  * encoding/decoding; make sure not to call this function from a time critical
- * path. Usually, init_bch() should be called on module/driver init and
- * free_bch() should be called to release memory on exit.
+ * path. The tables are shared by the workspaces of init_bch_workspace() and
+ * have to outlive them.
  *
  * You may provide your own primitive polynomial of degree @m in argument
- * @prim_poly, or let init_bch() use its default polynomial.
- *
- * Once init_bch() has successfully returned a pointer to a newly allocated
- * BCH control structure, ecc length in bytes is given by member @ecc_bytes of
- * the structure.
+ * @prim_poly, or let init_bch_tables() use its default polynomial.
  */
-struct bch_control* init_bch(int m, int t, unsigned int prim_poly)
+struct bch_tables* init_bch_tables(int m, int t, unsigned int prim_poly)
 {
     int err = 0;
-    unsigned int i, words;
+    unsigned int words;
     uint32_t* genpoly;
-    struct bch_control* bch = NULL;
+    struct bch_tables* tables = NULL;
+    struct bch_control bch;
 
     const int min_m = 5;
     const int max_m = 15;
@@ -1286,45 +1444,132 @@ struct bch_control* init_bch(int m, int t, unsigned int prim_poly)
     if (prim_poly == 0)
         prim_poly = prim_poly_tab[m - min_m];
 
-    bch = (struct bch_control*)malloc(sizeof(*bch));
-    if (bch == NULL)
+    tables = (struct bch_tables*)malloc(sizeof(*tables));
+    if (tables == NULL)
         goto fail;
-    memset(bch, 0, sizeof(*bch));
+    memset(tables, 0, sizeof(*tables));
 
-    bch->m = m;
-    bch->t = t;
-    bch->n = (1 << m) - 1;
+    tables->m = m;
+    tables->t = t;
+    tables->n = (1 << m) - 1;
     words = DIV_ROUND_UP(m * t, 32);
-    bch->ecc_bytes = DIV_ROUND_UP(m * t, 8);
-    bch->a_pow_tab = (uint16_t*)bch_alloc((1 + bch->n) * sizeof(*bch->a_pow_tab), &err);
-    bch->a_log_tab = (uint16_t*)bch_alloc((1 + bch->n) * sizeof(*bch->a_log_tab), &err);
-    bch->mod8_tab = (uint32_t*)bch_alloc(words * 1024 * sizeof(*bch->mod8_tab), &err);
-    bch->ecc_buf = (uint32_t*)bch_alloc(words * sizeof(*bch->ecc_buf), &err);
-    bch->ecc_buf2 = (uint32_t*)bch_alloc(words * sizeof(*bch->ecc_buf2), &err);
-    bch->xi_tab = (unsigned int*)bch_alloc(m * sizeof(*bch->xi_tab), &err);
-    bch->syn = (unsigned int*)bch_alloc(2 * t * sizeof(*bch->syn), &err);
-    bch->cache = (int*)bch_alloc(2 * t * sizeof(*bch->cache), &err);
-    bch->elp = (struct gf_poly*)bch_alloc((t + 1) * sizeof(struct gf_poly_deg1), &err);
-
-    for (i = 0; i < ARRAY_SIZE(bch->poly_2t); i++)
-        bch->poly_2t[i] = (struct gf_poly*)bch_alloc(GF_POLY_SZ(2 * t), &err);
+    tables->ecc_bytes = DIV_ROUND_UP(m * t, 8);
+    tables->a_pow_tab = (uint16_t*)bch_alloc((1 + tables->n) * sizeof(*tables->a_pow_tab), &err);
+    tables->a_log_tab = (uint16_t*)bch_alloc((1 + tables->n) * sizeof(*tables->a_log_tab), &err);
+    tables->mod8_tab = (uint32_t*)bch_alloc(words * 1024 * sizeof(*tables->mod8_tab), &err);
+    tables->xi_tab = (unsigned int*)bch_alloc(m * sizeof(*tables->xi_tab), &err);
+    if (t <= BCH_CLOSED_FORM_MAX_T) {
+        tables->deg2_tab = (uint16_t*)bch_alloc((1 + tables->n) * sizeof(*tables->deg2_tab), &err);
+        tables->deg3_tab = (uint16_t*)bch_alloc((1 + tables->n) * sizeof(*tables->deg3_tab), &err);
+    }
 
     if (err)
         goto fail;
 
-    err = build_gf_tables(bch, prim_poly);
+    /* the builders only touch the table part of a control structure */
+    memset(&bch, 0, sizeof(bch));
+    bch.m = tables->m;
+    bch.n = tables->n;
+    bch.t = tables->t;
+    bch.ecc_bytes = tables->ecc_bytes;
+    bch.a_pow_tab = tables->a_pow_tab;
+    bch.a_log_tab = tables->a_log_tab;
+    bch.mod8_tab = tables->mod8_tab;
+    bch.xi_tab = tables->xi_tab;
+
+    err = build_gf_tables(&bch, prim_poly);
     if (err)
         goto fail;
 
     /* use generator polynomial for computing encoding tables */
-    genpoly = compute_generator_polynomial(bch);
+    genpoly = compute_generator_polynomial(&bch);
     if (genpoly == NULL)
         goto fail;
 
-    build_mod8_tables(bch, genpoly);
+    build_mod8_tables(&bch, genpoly);
     free(genpoly);
+    tables->ecc_bits = bch.ecc_bits;
+
+    err = build_deg2_base(&bch);
+    if (err)
+        goto fail;
+
+    if (tables->deg2_tab) {
+        err = build_closed_form_tables(&bch, tables->deg2_tab, tables->deg3_tab);
+        if (err)
+            goto fail;
+    }
+
+    return tables;
+
+fail:
+    free_bch_tables(tables);
+    return NULL;
+}
+
+/**
+ *  free_bch_tables - free the tables of init_bch_tables
+ *  @tables:    tables to release, no workspace may use them any more
+ */
+void free_bch_tables(struct bch_tables* tables)
+{
+    if (tables) {
+        free(tables->a_pow_tab);
+        free(tables->a_log_tab);
+        free(tables->mod8_tab);
+        free(tables->xi_tab);
+        free(tables->deg2_tab);
+        free(tables->deg3_tab);
+
+        free(tables);
+    }
+}
+
+/**
+ * init_bch_workspace - allocate the mutable buffers of one BCH user
+ * @tables:     tables of init_bch_tables, they have to outlive the workspace
+ *
+ * Returns:
+ *  a newly allocated BCH control structure if successful, NULL otherwise
+ *
+ * Only the scratch of encoding and decoding is allocated, so this is cheap
+ * compared to init_bch_tables(). Every thread needs its own workspace.
+ * Decoding uses the closed forms if t <= BCH_CLOSED_FORM_MAX_T, clear
+ * @closed_form to go through Berlekamp-Massey and find_poly_roots instead.
+ */
+struct bch_control* init_bch_workspace(struct bch_tables* tables)
+{
+    int err = 0;
+    unsigned int i, words;
+    const unsigned int t = tables->t;
+    struct bch_control* bch = NULL;
+
+    bch = (struct bch_control*)malloc(sizeof(*bch));
+    if (bch == NULL)
+        goto fail;
+    memset(bch, 0, sizeof(*bch));
+
+    bch->m = tables->m;
+    bch->t = tables->t;
+    bch->n = tables->n;
+    bch->ecc_bits = tables->ecc_bits;
+    bch->ecc_bytes = tables->ecc_bytes;
+    bch->tables = tables;
+    bch->a_pow_tab = tables->a_pow_tab;
+    bch->a_log_tab = tables->a_log_tab;
+    bch->mod8_tab = tables->mod8_tab;
+    bch->xi_tab = tables->xi_tab;
+    bch->closed_form = tables->deg2_tab != NULL;
+    words = DIV_ROUND_UP(bch->m * t, 32);
+    bch->ecc_buf = (uint32_t*)bch_alloc(words * sizeof(*bch->ecc_buf), &err);
+    bch->ecc_buf2 = (uint32_t*)bch_alloc(words * sizeof(*bch->ecc_buf2), &err);
+    bch->syn = (unsigned int*)bch_alloc(2 * t * sizeof(*bch->syn), &err);
+    bch->cache = (int*)bch_alloc(2 * t * sizeof(*bch->cache), &err);
+    bch->elp = (struct gf_poly*)bch_alloc((t + 1) * sizeof(struct gf_poly_deg1), &err);
+
+    for (i = 0; i < ARRAY_SIZE(bch->poly_2t); i++)
+        bch->poly_2t[i] = (struct gf_poly*)bch_alloc(GF_POLY_SZ(2 * t), &err);
 
-    err = build_deg2_base(bch);
     if (err)
         goto fail;
 
@@ -1335,6 +1580,46 @@ fail:
     return NULL;
 }
 
+/**
+ * init_bch - initialize a BCH encoder/decoder
+ * @m:          Galois field order, should be in the range 5-15
+ * @t:          maximum error correction capability, in bits
+ * @prim_poly:  user-provided primitive polynomial (or 0 to use default)
+ *
+ * Returns:
+ *  a newly allocated BCH control structure if successful, NULL otherwise
+ *
+ * This initialization can take some time, as lookup tables are built for fast
+ * encoding/decoding; make sure not to call this function from a time critical
+ * path. Usually, init_bch() should be called on module/driver init and
+ * free_bch() should be called to release memory on exit.
+ *
+ * The control structure owns its tables, see init_bch_tables() to share them.
+ *
+ * You may provide your own primitive polynomial of degree @m in argument
+ * @prim_poly, or let init_bch() use its default polynomial.
+ *
+ * Once init_bch() has successfully returned a pointer to a newly allocated
+ * BCH control structure, ecc length in bytes is given by member @ecc_bytes of
+ * the structure.
+ */
+struct bch_control* init_bch(int m, int t, unsigned int prim_poly)
+{
+    struct bch_control* bch;
+    struct bch_tables* tables = init_bch_tables(m, t, prim_poly);
+
+    if (tables == NULL)
+        return NULL;
+
+    bch = init_bch_workspace(tables);
+    if (bch == NULL) {
+        free_bch_tables(tables);
+        return NULL;
+    }
+    bch->own_tables = 1;
+    return bch;
+}
+
 /**
  *  free_bch - free the BCH control structure
  *  @bch:    BCH control structure to release
@@ -1344,12 +1629,8 @@ void free_bch(struct bch_control* bch)
     unsigned int i;
 
     if (bch) {
-        free(bch->a_pow_tab);
-        free(bch->a_log_tab);
-        free(bch->mod8_tab);
         free(bch->ecc_buf);
         free(bch->ecc_buf2);
-        free(bch->xi_tab);
         free(bch->syn);
         free(bch->cache);
         free(bch->elp);
@@ -1359,6 +1640,9 @@ void free_bch(struct bch_control* bch)
 
         free(bch->databuf);
 
+        if (bch->own_tables)
+            free_bch_tables(bch->tables);
+
         free(bch);
     }
 }
@@ -32,13 +32,49 @@
 extern "C" {
 #endif
 
+/* largest t with closed form decoders */
+#define BCH_CLOSED_FORM_MAX_T 3
+
+/**
+ * struct bch_tables - read-only part of a BCH code, shared by its workspaces
+ * @m:          Galois field order
+ * @n:          maximum codeword size in bits (= 2^m-1)
+ * @t:          error correction capability in bits
+ * @ecc_bits:   ecc exact size in bits, i.e. generator polynomial degree (<=m*t)
+ * @ecc_bytes:  ecc max size (m*t bits) in bytes
+ * @a_pow_tab:  Galois field GF(2^m) exponentiation lookup table
+ * @a_log_tab:  Galois field GF(2^m) log lookup table
+ * @mod8_tab:   remainder generator polynomial lookup tables
+ * @xi_tab:     GF(2^m) base for solving degree 2 polynomial roots
+ * @deg2_tab:   a root y of y^2+y+c for every c, 0 if there is none, only for t <= BCH_CLOSED_FORM_MAX_T
+ * @deg3_tab:   a root w of w^3+w+c for every c if it has 3 distinct roots, 0 otherwise, only for t <= BCH_CLOSED_FORM_MAX_T
+ */
+struct bch_tables {
+    unsigned int m;
+    unsigned int n;
+    unsigned int t;
+    unsigned int ecc_bits;
+    unsigned int ecc_bytes;
+    uint16_t* a_pow_tab;
+    uint16_t* a_log_tab;
+    uint32_t* mod8_tab;
+    unsigned int* xi_tab;
+    uint16_t* deg2_tab;
+    uint16_t* deg3_tab;
+};
+
 /**
- * struct bch_control - BCH control structure
+ * struct bch_control - BCH control structure, the mutable workspace of one user of a bch_tables
  * @m:          Galois field order
  * @n:          maximum codeword size in bits (= 2^m-1)
  * @t:          error correction capability in bits
  * @ecc_bits:   ecc exact size in bits, i.e. generator polynomial degree (<=m*t)
  * @ecc_bytes:  ecc max size (m*t bits) in bytes
+ * @closed_form: decode with the Peterson closed forms instead of Berlekamp-Massey and root finding, set if the tables allow it
+ * @root_search: finds the distinct roots e (as in a^e) of error locators of degree > 4 in place of find_poly_roots, NULL by default
+ * @root_search_context: first argument of @root_search
+ * @tables:     shared read-only tables, a_pow_tab to xi_tab alias them
+ * @own_tables: tables are released by free_bch, set by init_bch
  * @a_pow_tab:  Galois field GF(2^m) exponentiation lookup table
  * @a_log_tab:  Galois field GF(2^m) log lookup table
  * @mod8_tab:   remainder generator polynomial lookup tables
@@ -56,7 +92,12 @@ struct bch_control {
     unsigned int t;
     unsigned int ecc_bits;
     unsigned int ecc_bytes;
+    int closed_form;
+    int (*root_search)(void* context, const unsigned int* c, unsigned int deg, unsigned int* roots);
+    void* root_search_context;
     /* private: */
+    struct bch_tables* tables;
+    int own_tables;
     uint16_t* a_pow_tab;
     uint16_t* a_log_tab;
     uint32_t* mod8_tab;
@@ -70,6 +111,12 @@ struct bch_control {
     uint8_t* databuf;
 };
 
+struct bch_tables* init_bch_tables(int m, int t, unsigned int prim_poly);
+
+void free_bch_tables(struct bch_tables* tables);
+
+struct bch_control* init_bch_workspace(struct bch_tables* tables);
+
 struct bch_control* init_bch(int m, int t, unsigned int prim_poly);
 
 void free_bch(struct bch_control* bch);
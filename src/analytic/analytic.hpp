@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "ecc/ecc.hpp"
+
+// results of an analytic full run, laid out like the collected thread results
+struct analytic_result {
+    ecc_stats stats;
+    std::vector<uint64_t> flip_occurence_counts;
+    std::vector<int64_t> flip_occurence_flip_avg_distances; // summed distances, averaged by the caller
+};
@@ -0,0 +1,151 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "ecc/ecc.hpp"
+
+#include "analytic/macwilliams.hpp"
+
+bool macwilliams_fits(ECCMethod* method, uint32_t max_weight)
+{
+    const uint32_t ecc_width = method->ECCWidth();
+    const uint32_t word_width = method->DataWidth() + ecc_width;
+    const uint32_t padding_width = method->PaddingWidth();
+    if (ecc_width > MACWILLIAMS_MAX_ECC_BITS || padding_width > 64) {
+        return false;
+    }
+    // every krawtchouk value is bounded by its binomial, so the sums stay below 2^k * C(n, w) * C(p, b)
+    long double bound = std::ldexp(1.0L, ecc_width);
+    for (uint32_t i = 0; i < std::min(max_weight, word_width / 2); i++) {
+        bound = bound * (word_width - i) / (i + 1);
+    }
+    for (uint32_t i = 0; i < padding_width / 2; i++) {
+        bound = bound * (padding_width - i) / (i + 1);
+    }
+    return bound < std::ldexp(1.0L, 125);
+}
+
+// krawtchouk[w][j] = sum_s (-1)^s C(j, s) C(n - j, w - s), the weight w coefficient of (1 - z)^j (1 + z)^(n - j)
+static std::vector<std::vector<__int128>> macwilliams_krawtchouk(uint32_t n, uint32_t max_weight)
+{
+    std::vector<std::vector<__int128>> binomials(n + 1, std::vector<__int128>(n + 1, 0));
+    for (uint32_t i = 0; i <= n; i++) {
+        binomials[i][0] = 1;
+        for (uint32_t k = 1; k <= i && k <= max_weight; k++) {
+            binomials[i][k] = binomials[i - 1][k - 1] + (k < i ? binomials[i - 1][k] : 0);
+        }
+    }
+    std::vector<std::vector<__int128>> ret(max_weight + 1, std::vector<__int128>(n + 1, 0));
+    for (uint32_t w = 0; w <= max_weight; w++) {
+        for (uint32_t j = 0; j <= n; j++) {
+            for (uint32_t s = 0; s <= j && s <= w; s++) {
+                if (w - s > n - j) {
+                    continue;
+                }
+                __int128 term = binomials[j][s] * binomials[n - j][w - s];
+                ret[w][j] += s % 2 == 0 ? term : -term;
+            }
+        }
+    }
+    return ret;
+}
+
+std::vector<std::vector<uint64_t>> macwilliams_weight_spectrum(ECCMethod* method, uint32_t max_weight, uint32_t thread_count)
+{
+    const uint32_t ecc_width = method->ECCWidth();
+    const uint32_t word_width = method->DataWidth() + ecc_width;
+    const uint32_t padding_width = method->PaddingWidth();
+    max_weight = std::min(max_weight, word_width);
+    assert(macwilliams_fits(method, max_weight));
+
+    // parity check rows, bit j of every column syndrome, as word bitmaps plus a separate padding bitmap
+    const uint32_t row_words = (word_width + 63) / 64;
+    std::vector<uint64_t> word_rows(ecc_width * row_words, 0);
+    std::vector<uint64_t> padding_rows(ecc_width, 0);
+    for (uint32_t bit_pos = 0; bit_pos < word_width + padding_width; bit_pos++) {
+        ecc_syndrome column = method->ColumnSyndrome(bit_pos);
+        for (uint32_t row = 0; row < ecc_width; row++) {
+            if (!column.get(row)) {
+                continue;
+            } else if (bit_pos < word_width) {
+                word_rows[row * row_words + bit_pos / 64] |= (uint64_t)1 << (bit_pos % 64);
+            } else {
+                padding_rows[row] |= (uint64_t)1 << (bit_pos - word_width);
+            }
+        }
+    }
+
+    // dual_weights[jp * (n + 1) + jw], the dual word of gray(u) differs from the previous one by the row of the lowest set bit of u
+    const uint64_t dual_size = (uint64_t)1 << ecc_width;
+    std::vector<std::vector<uint64_t>> thread_dual_weights(thread_count, std::vector<uint64_t>((padding_width + 1) * (word_width + 1), 0));
+    std::vector<std::thread> workers;
+    for (uint32_t tid = 0; tid < thread_count; tid++) {
+        workers.emplace_back([&, tid]() {
+            std::vector<uint64_t>& dual_weights = thread_dual_weights[tid];
+            uint64_t begin = dual_size * tid / thread_count;
+            uint64_t end = dual_size * (tid + 1) / thread_count;
+            if (begin >= end) {
+                return;
+            }
+            std::vector<uint64_t> word(row_words, 0);
+            uint64_t padding = 0;
+            uint64_t gray = begin ^ (begin >> 1);
+            for (uint32_t row = 0; row < ecc_width; row++) {
+                if ((gray >> row) & 0b1) {
+                    for (uint32_t i = 0; i < row_words; i++) {
+                        word[i] ^= word_rows[row * row_words + i];
+                    }
+                    padding ^= padding_rows[row];
+                }
+            }
+            for (uint64_t u = begin;; u++) {
+                uint32_t word_weight = 0;
+                for (uint32_t i = 0; i < row_words; i++) {
+                    word_weight += __builtin_popcountll(word[i]);
+                }
+                dual_weights[__builtin_popcountll(padding) * (word_width + 1) + word_weight]++;
+                if (u + 1 == end) {
+                    break;
+                }
+                uint32_t row = __builtin_ctzll(u + 1);
+                for (uint32_t i = 0; i < row_words; i++) {
+                    word[i] ^= word_rows[row * row_words + i];
+                }
+                padding ^= padding_rows[row];
+            }
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    std::vector<uint64_t> dual_weights((padding_width + 1) * (word_width + 1), 0);
+    for (uint32_t tid = 0; tid < thread_count; tid++) {
+        for (uint64_t i = 0; i < dual_weights.size(); i++) {
+            dual_weights[i] += thread_dual_weights[tid][i];
+        }
+    }
+
+    // MacWilliams on the split weight enumerator, the padding and word coordinates transform independently
+    std::vector<std::vector<__int128>> word_krawtchouk = macwilliams_krawtchouk(word_width, max_weight);
+    std::vector<std::vector<__int128>> padding_krawtchouk = macwilliams_krawtchouk(padding_width, padding_width);
+    std::vector<std::vector<uint64_t>> ret(padding_width + 1, std::vector<uint64_t>(max_weight + 1, 0));
+    for (uint32_t b = 0; b <= padding_width; b++) {
+        for (uint32_t w = 0; w <= max_weight; w++) {
+            __int128 acc = 0;
+            for (uint32_t jp = 0; jp <= padding_width; jp++) {
+                for (uint32_t jw = 0; jw <= word_width; jw++) {
+                    uint64_t count = dual_weights[jp * (word_width + 1) + jw];
+                    if (count != 0) {
+                        acc += (__int128)count * padding_krawtchouk[b][jp] * word_krawtchouk[w][jw];
+                    }
+                }
+            }
+            assert(acc >= 0 && (acc & (((__int128)1 << ecc_width) - 1)) == 0);
+            ret[b][w] = acc >> ecc_width;
+        }
+    }
+    return ret;
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "ecc/ecc.hpp"
+
+static const uint32_t MACWILLIAMS_MAX_ECC_BITS = 36;
+
+// false if the dual code is too large to enumerate or the transform of the weights up to max_weight could overflow 128 bits
+bool macwilliams_fits(ECCMethod* method, uint32_t max_weight);
+
+// codeword counts split by padding and word weight as needed by sphere_outcomes_from_weights, rows b = 0..PaddingWidth(), columns w = 0..max_weight
+// the 2^k words of the dual code are the combinations of the parity check rows, enumerated in gray code order and split across threads,
+// their weight distribution is then turned into the one of the code by the MacWilliams identity
+std::vector<std::vector<uint64_t>> macwilliams_weight_spectrum(ECCMethod* method, uint32_t max_weight, uint32_t thread_count);
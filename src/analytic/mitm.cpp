@@ -0,0 +1,326 @@
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "ecc/ecc.hpp"
+#include "util/combinations.hpp"
+
+#include "analytic/mitm.hpp"
+
+static const uint64_t MITM_MEMORY_BUDGET = (uint64_t)2 << 30; // bytes for the table partitions and scatter buffers of one pass
+static const uint64_t MITM_BUFFER_BUDGET = MITM_MEMORY_BUDGET / 4; // of which the scatter buffers of one build round
+static const uint32_t MITM_MAX_PASS_BITS = 16;
+
+struct mitm_entry {
+    uint64_t key[2];
+    uint64_t count; // 0 marks an empty slot
+};
+
+struct mitm_key {
+    uint64_t w[2];
+};
+
+// the table of all small-subsets is split into passes by pass_bits parities of their syndromes, which are linear, so the pass of a
+// subset is the xor of the passes of its columns and the subsets of one pass are enumerated as a prefix plus a last column picked by
+// its pass, within a pass the syndromes are hashed to one table partition per thread
+struct mitm_plan {
+    uint32_t pass_bits = 0;
+    std::vector<uint32_t> column_passes;
+    std::vector<std::vector<uint32_t>> pass_columns; // ascending columns of every pass
+    std::vector<uint64_t> pass_sizes; // small-subsets of every pass
+    uint64_t capacity = 0; // slots of every table partition
+};
+
+static uint64_t mitm_hash(const uint64_t* key)
+{
+    uint64_t h = (key[0] ^ (key[1] * 0x9E3779B97F4A7C15)) * 0xBF58476D1CE4E5B9;
+    return h ^ (h >> 29);
+}
+
+// table partition of a hashed syndrome, independent of the slot bits
+static inline uint32_t mitm_partition(uint64_t h, uint32_t thread_count)
+{
+    return (uint32_t)(((h >> 32) * thread_count) >> 32);
+}
+
+// slots of every table partition for at most entries syndromes, load factor <= 1/2
+static uint64_t mitm_capacity(uint64_t entries, uint32_t thread_count)
+{
+    return (uint64_t)1 << (64 - __builtin_clzll(2 * (entries / thread_count) + 16));
+}
+
+// bytes of a pass of subsets subsets of which at most entries are distinct, the build is split into rounds to bound the buffers
+static uint64_t mitm_pass_bytes(uint64_t subsets, uint64_t entries, uint32_t thread_count)
+{
+    return mitm_capacity(entries, thread_count) * sizeof(mitm_entry) * thread_count + std::min(subsets * sizeof(mitm_key), MITM_BUFFER_BUDGET);
+}
+
+// distinct syndromes of ecc_width bits
+static uint64_t mitm_syndrome_space(uint32_t ecc_width)
+{
+    return ecc_width >= 64 ? UINT64_MAX : (uint64_t)1 << ecc_width;
+}
+
+// pass bits of evenly split table_count subsets that fit the budget, no fewer are needed
+static uint32_t mitm_min_pass_bits(uint64_t table_count, uint32_t ecc_width, uint32_t thread_count)
+{
+    uint32_t pass_bits = 0;
+    while (pass_bits < MITM_MAX_PASS_BITS) {
+        uint64_t subsets = (table_count >> pass_bits) + 1;
+        if (mitm_pass_bytes(subsets, std::min(subsets, mitm_syndrome_space(ecc_width)), thread_count) <= MITM_MEMORY_BUDGET) {
+            break;
+        }
+        pass_bits++;
+    }
+    return pass_bits;
+}
+
+// calls fn(syndrome, pass, first_free) for the size-subsets of the columns with rank in [begin, end), stepping in revolving door order
+// with two xors per subset, first_free is one past the last column of the subset
+template <typename F>
+static void mitm_for_each_subset(const std::vector<uint64_t>& columns, const mitm_plan& plan, uint32_t size, uint64_t begin, uint64_t end, F fn)
+{
+    if (begin >= end) {
+        return;
+    }
+    const uint32_t n = columns.size() / 2;
+    uint64_t syndrome[2] = {0, 0};
+    uint32_t pass = 0;
+    RevolvingDoorCombination combination(n, size, begin);
+    const uint32_t* positions = combination.Positions();
+    for (uint32_t i = 0; i < size; i++) {
+        syndrome[0] ^= columns[2 * positions[i]];
+        syndrome[1] ^= columns[2 * positions[i] + 1];
+        pass ^= plan.column_passes[positions[i]];
+    }
+    fn(syndrome, pass, size == 0 ? 0 : positions[size - 1] + 1);
+    for (uint64_t idx = begin + 1; idx < end; idx++) {
+        uint32_t out_pos;
+        uint32_t in_pos;
+        combination.Next(out_pos, in_pos);
+        syndrome[0] ^= columns[2 * out_pos] ^ columns[2 * in_pos];
+        syndrome[1] ^= columns[2 * out_pos + 1] ^ columns[2 * in_pos + 1];
+        pass ^= plan.column_passes[out_pos] ^ plan.column_passes[in_pos];
+        fn(syndrome, pass, positions[size - 1] + 1);
+    }
+}
+
+// calls fn(syndrome) for the (size + 1)-subsets in the given pass whose first size columns form a size-subset with rank in
+// [begin, end), every subset of the pass is reached from exactly one prefix
+template <typename F>
+static void mitm_for_each_extension(const std::vector<uint64_t>& columns, const mitm_plan& plan, uint32_t size, uint64_t begin, uint64_t end, uint32_t pass, F fn)
+{
+    mitm_for_each_subset(columns, plan, size, begin, end, [&](const uint64_t* syndrome, uint32_t prefix_pass, uint32_t first_free) {
+        const std::vector<uint32_t>& last_columns = plan.pass_columns[pass ^ prefix_pass];
+        for (auto it = last_columns.rbegin(); it != last_columns.rend() && *it >= first_free; ++it) {
+            uint64_t extended[2] = {syndrome[0] ^ columns[2 * *it], syndrome[1] ^ columns[2 * *it + 1]};
+            fn(extended);
+        }
+    });
+}
+
+// the fewest pass bits whose largest pass fits the budget, the passes are counted exactly by a dp over the columns
+static mitm_plan mitm_plan_passes(const std::vector<uint64_t>& columns, uint32_t small, uint32_t ecc_width, uint32_t thread_count)
+{
+    const uint32_t n = columns.size() / 2;
+    mitm_plan plan;
+    for (plan.pass_bits = mitm_min_pass_bits(nCr(n, small), ecc_width, thread_count);; plan.pass_bits++) {
+        if (plan.pass_bits > MITM_MAX_PASS_BITS) {
+            printf("mitm tables of %u-subsets do not fit the memory budget\n", small);
+            assert(0);
+            exit(-1);
+        }
+        const uint32_t pass_count = (uint32_t)1 << plan.pass_bits;
+        plan.column_passes.assign(n, 0);
+        for (uint32_t bit = 0; bit < plan.pass_bits; bit++) {
+            // fixed pseudo random masks, any that are linearly independent on the column syndromes split evenly enough
+            const uint64_t seed[2] = {2 * bit + 1, 0};
+            const uint64_t mask[2] = {mitm_hash(seed), mitm_hash(seed) * 0x94D049BB133111EB};
+            for (uint32_t c = 0; c < n; c++) {
+                uint64_t masked = (columns[2 * c] & mask[0]) ^ (columns[2 * c + 1] & mask[1]);
+                plan.column_passes[c] |= (uint32_t)__builtin_parityll(masked) << bit;
+            }
+        }
+        // subsets[q][pass] of the columns so far
+        std::vector<uint64_t> subsets((small + 1) * pass_count, 0);
+        subsets[0] = 1;
+        for (uint32_t c = 0; c < n; c++) {
+            for (uint32_t q = std::min(c + 1, small); q >= 1; q--) {
+                for (uint32_t pass = 0; pass < pass_count; pass++) {
+                    subsets[q * pass_count + pass] += subsets[(q - 1) * pass_count + (pass ^ plan.column_passes[c])];
+                }
+            }
+        }
+        plan.pass_sizes.assign(subsets.begin() + small * pass_count, subsets.end());
+        uint64_t largest = *std::max_element(plan.pass_sizes.begin(), plan.pass_sizes.end());
+        uint64_t entries = std::min(largest, mitm_syndrome_space(ecc_width));
+        if (mitm_pass_bytes(largest, entries, thread_count) <= MITM_MEMORY_BUDGET) {
+            plan.capacity = mitm_capacity(entries, thread_count);
+            break;
+        }
+    }
+    plan.pass_columns.assign((size_t)1 << plan.pass_bits, std::vector<uint32_t>());
+    for (uint32_t c = 0; c < n; c++) {
+        plan.pass_columns[plan.column_passes[c]].push_back(c);
+    }
+    return plan;
+}
+
+// runs fn(tid) on thread_count threads and waits for them
+template <typename F>
+static void mitm_parallel(uint32_t thread_count, F fn)
+{
+    std::vector<std::thread> workers;
+    for (uint32_t tid = 0; tid < thread_count; tid++) {
+        workers.emplace_back(fn, tid);
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+double mitm_visit_count(ECCMethod* method, uint32_t max_weight, uint32_t thread_count)
+{
+    const uint32_t n = method->DataWidth() + method->ECCWidth();
+    max_weight = std::min(max_weight, n);
+    double visits = 0;
+    for (uint32_t small = 0; 2 * small <= max_weight; small++) {
+        uint128_t table_count = nCr128(n, small);
+        uint32_t pass_bits = table_count > UINT64_MAX ? MITM_MAX_PASS_BITS : mitm_min_pass_bits((uint64_t)table_count, method->ECCWidth(), thread_count);
+        double pass_count = (double)((uint64_t)1 << pass_bits);
+        visits += (double)table_count + (small > 0 ? pass_count * (double)nCr128(n, small - 1) : 0);
+        if (2 * small + 1 <= max_weight) {
+            visits += (double)nCr128(n, small + 1) + pass_count * (double)table_count;
+        }
+    }
+    return visits;
+}
+
+std::vector<uint64_t> mitm_weight_spectrum(ECCMethod* method, uint32_t max_weight, uint32_t thread_count)
+{
+    assert(method->ECCWidth() <= MITM_MAX_SYNDROME_BITS);
+    const uint32_t n = method->DataWidth() + method->ECCWidth();
+    max_weight = std::min(max_weight, n);
+    std::vector<uint64_t> columns(2 * n);
+    for (uint32_t bit_pos = 0; bit_pos < n; bit_pos++) {
+        ecc_syndrome column = method->ColumnSyndrome(bit_pos);
+        columns[2 * bit_pos] = column.w[0];
+        columns[2 * bit_pos + 1] = column.w[1];
+    }
+
+    std::vector<uint64_t> weights(max_weight + 1, 0);
+    weights[0] = 1;
+    // the table of all small-subsets serves w = 2 * small (joined with itself) and w = 2 * small + 1 (probed by the (small + 1)-subsets)
+    for (uint32_t small = 0; 2 * small <= max_weight; small++) {
+        const bool odd_weight = 2 * small + 1 <= max_weight;
+        const mitm_plan plan = mitm_plan_passes(columns, small, method->ECCWidth(), thread_count);
+        const uint64_t mask = plan.capacity - 1;
+        // the small-subsets are reached as prefixes of small - 1 columns and the probe subsets as prefixes of small columns
+        const uint64_t build_prefix_count = small > 0 ? nCr(n, small - 1) : 0;
+        const uint64_t probe_prefix_count = odd_weight ? nCr(n, small) : 0;
+
+        std::vector<std::vector<mitm_entry>> tables(thread_count, std::vector<mitm_entry>(plan.capacity));
+        // buffers[tid][partition] of the syndromes thread tid built for the table partition
+        std::vector<std::vector<std::vector<mitm_key>>> buffers(thread_count, std::vector<std::vector<mitm_key>>(thread_count));
+        std::vector<unsigned __int128> thread_even_pairs(thread_count, 0);
+        std::vector<unsigned __int128> thread_odd_pairs(thread_count, 0);
+        for (uint32_t pass = 0; pass < plan.pass_sizes.size(); pass++) {
+            if (plan.pass_sizes[pass] == 0) {
+                continue;
+            }
+            mitm_parallel(thread_count, [&](uint32_t tid) { std::fill(tables[tid].begin(), tables[tid].end(), mitm_entry()); });
+
+            // build, every thread scatters the subsets of its prefix rank range into the buffers of the partitions, which their
+            // owners then insert, rounds of a prefix rank slice each bound the buffers
+            const uint64_t rounds = (plan.pass_sizes[pass] * sizeof(mitm_key) + MITM_BUFFER_BUDGET - 1) / MITM_BUFFER_BUDGET;
+            for (uint64_t round = 0; round < rounds; round++) {
+                mitm_parallel(thread_count, [&](uint32_t tid) {
+                    auto scatter = [&](const uint64_t* syndrome) {
+                        buffers[tid][mitm_partition(mitm_hash(syndrome), thread_count)].push_back({{syndrome[0], syndrome[1]}});
+                    };
+                    if (small == 0) {
+                        if (tid == 0 && round == 0) {
+                            const uint64_t empty[2] = {0, 0};
+                            scatter(empty);
+                        }
+                        return;
+                    }
+                    uint64_t begin = build_prefix_count * tid / thread_count;
+                    uint64_t end = build_prefix_count * (tid + 1) / thread_count;
+                    uint64_t round_begin = begin + (end - begin) * round / rounds;
+                    uint64_t round_end = begin + (end - begin) * (round + 1) / rounds;
+                    mitm_for_each_extension(columns, plan, small - 1, round_begin, round_end, pass, scatter);
+                });
+                mitm_parallel(thread_count, [&](uint32_t tid) {
+                    std::vector<mitm_entry>& table = tables[tid];
+                    for (uint32_t source = 0; source < thread_count; source++) {
+                        for (const mitm_key& key : buffers[source][tid]) {
+                            for (uint64_t slot = mitm_hash(key.w) & mask;; slot = (slot + 1) & mask) {
+                                mitm_entry& entry = table[slot];
+                                if (entry.count == 0) {
+                                    entry.key[0] = key.w[0];
+                                    entry.key[1] = key.w[1];
+                                    entry.count = 1;
+                                    break;
+                                } else if (entry.key[0] == key.w[0] && entry.key[1] == key.w[1]) {
+                                    entry.count++;
+                                    break;
+                                }
+                            }
+                        }
+                        buffers[source][tid].clear();
+                    }
+                });
+            }
+            mitm_parallel(thread_count, [&](uint32_t tid) {
+                for (const mitm_entry& entry : tables[tid]) {
+                    thread_even_pairs[tid] += (unsigned __int128)entry.count * entry.count;
+                }
+            });
+
+            // probe, the (small + 1)-subsets of the pass are split by prefix rank ranges and looked up in the partition owning the syndrome
+            if (odd_weight) {
+                mitm_parallel(thread_count, [&](uint32_t tid) {
+                    uint64_t begin = probe_prefix_count * tid / thread_count;
+                    uint64_t end = probe_prefix_count * (tid + 1) / thread_count;
+                    mitm_for_each_extension(columns, plan, small, begin, end, pass, [&](const uint64_t* syndrome) {
+                        uint64_t h = mitm_hash(syndrome);
+                        const std::vector<mitm_entry>& table = tables[mitm_partition(h, thread_count)];
+                        for (uint64_t slot = h & mask; table[slot].count != 0; slot = (slot + 1) & mask) {
+                            if (table[slot].key[0] == syndrome[0] && table[slot].key[1] == syndrome[1]) {
+                                thread_odd_pairs[tid] += table[slot].count;
+                                break;
+                            }
+                        }
+                    });
+                });
+            }
+        }
+        unsigned __int128 even_pairs = 0;
+        unsigned __int128 odd_pairs = 0;
+        for (uint32_t tid = 0; tid < thread_count; tid++) {
+            even_pairs += thread_even_pairs[tid];
+            odd_pairs += thread_odd_pairs[tid];
+        }
+
+        // an (a, b) pair with j shared columns xors to a codeword of weight w - 2j, and each such codeword splits into
+        // C(w - 2j, a - j) * C(n - w + 2j, j) pairs, the j = 0 term is the one solved for
+        for (uint32_t w = 2 * small; w <= 2 * small + 1 && w <= max_weight; w++) {
+            if (w == 0) {
+                continue;
+            }
+            const uint32_t a = w - small;
+            const uint32_t b = small;
+            unsigned __int128 pairs = w % 2 == 0 ? even_pairs : odd_pairs;
+            for (uint32_t j = 1; j <= b; j++) {
+                pairs -= (unsigned __int128)weights[w - 2 * j] * nCr(w - 2 * j, a - j) * nCr(n - w + 2 * j, j);
+            }
+            weights[w] = pairs / nCr(w, a);
+        }
+    }
+    return weights;
+}
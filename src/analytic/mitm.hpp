@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "ecc/ecc.hpp"
+
+static const uint32_t MITM_MAX_SYNDROME_BITS = 128;
+
+// number of codewords of every weight 0..max_weight of the code, counted by meeting in the middle
+// a w-subset of columns splits into halves of ceil(w/2) and floor(w/2) columns with equal syndromes, so the syndromes of all larger halves
+// are hashed (one table partition per thread) and joined against the smaller halves, pairs of overlapping halves are then removed again
+// using the lower weight counts, tables past the memory budget are built and probed in passes over disjoint slices of the syndromes
+std::vector<uint64_t> mitm_weight_spectrum(ECCMethod* method, uint32_t max_weight, uint32_t thread_count);
+
+// half patterns mitm_weight_spectrum visits, the table and probe halves once each plus their prefixes once per pass, for cost estimates
+double mitm_visit_count(ECCMethod* method, uint32_t max_weight, uint32_t thread_count);
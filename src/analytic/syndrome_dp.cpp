@@ -0,0 +1,95 @@
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#include "ecc/decode_table.hpp"
+#include "ecc/ecc.hpp"
+#include "util/combinations.hpp"
+
+#include "analytic/syndrome_dp.hpp"
+
+uint64_t syndrome_dp_bytes(ECCMethod* method, uint32_t fail_count)
+{
+    return (uint64_t)(fail_count + 1) * ((uint64_t)1 << method->ECCWidth()) * 2 * sizeof(uint64_t);
+}
+
+bool syndrome_dp_fits(ECCMethod* method, uint32_t fail_count)
+{
+    uint32_t word_width = method->DataWidth() + method->ECCWidth();
+    if (fail_count > word_width || method->ECCWidth() > ECCDecodeTable::MAX_SYNDROME_BITS) {
+        return false;
+    }
+    return nCr128(word_width, fail_count) <= UINT64_MAX && syndrome_dp_bytes(method, fail_count) <= SYNDROME_DP_MAX_BYTES;
+}
+
+void syndrome_dp_full_run(ECCMethod* method, const ECCDecodeTable& table, uint32_t fail_count, analytic_result& result)
+{
+    assert(syndrome_dp_fits(method, fail_count));
+    const uint32_t word_width = method->DataWidth() + method->ECCWidth();
+    const uint64_t size = table.Size();
+
+    std::vector<uint64_t> columns(word_width);
+    for (uint32_t bit_pos = 0; bit_pos < word_width; bit_pos++) {
+        columns[bit_pos] = method->ColumnSyndrome(bit_pos).w[0];
+    }
+
+    // layer j holds, per syndrome, how many j-subsets of the columns seen so far land on it, and the summed positions of those subsets
+    std::vector<uint64_t> counts((uint64_t)(fail_count + 1) * size, 0);
+    std::vector<uint64_t> position_sums((uint64_t)(fail_count + 1) * size, 0);
+    counts[0] = 1;
+    for (uint32_t bit_pos = 0; bit_pos < word_width; bit_pos++) {
+        const uint64_t column = columns[bit_pos];
+        // descending layers, so every column joins a subset at most once
+        for (uint32_t j = std::min(fail_count, bit_pos + 1); j >= 1; j--) {
+            const uint64_t* src_counts = &counts[(uint64_t)(j - 1) * size];
+            const uint64_t* src_sums = &position_sums[(uint64_t)(j - 1) * size];
+            uint64_t* dst_counts = &counts[(uint64_t)j * size];
+            uint64_t* dst_sums = &position_sums[(uint64_t)j * size];
+            for (uint64_t s = 0; s < size; s++) {
+                dst_counts[s ^ column] += src_counts[s];
+                dst_sums[s ^ column] += src_sums[s] + bit_pos * src_counts[s];
+            }
+        }
+    }
+
+    result.stats = ecc_stats();
+    result.flip_occurence_counts.assign(word_width, 0);
+    result.flip_occurence_flip_avg_distances.assign(word_width, 0);
+    const uint64_t* final_counts = &counts[(uint64_t)fail_count * size];
+    const uint64_t* final_sums = &position_sums[(uint64_t)fail_count * size];
+    for (uint64_t s = 0; s < size; s++) {
+        uint64_t count = final_counts[s];
+        if (count == 0) {
+            continue;
+        }
+        uint32_t entry = table.Entry(s);
+        if (entry == ECCDecodeTable::ENTRY_OK) {
+            result.stats.detection_ok += count;
+            continue;
+        } else if (entry == ECCDecodeTable::ENTRY_UNCORRECTABLE) {
+            result.stats.detection_uncorrectable += count;
+            continue;
+        }
+        const uint32_t* corrections = &entry;
+        uint32_t correction_count = 1;
+        if ((entry & ECCDecodeTable::ENTRY_SET_FLAG) != 0) {
+            const uint32_t* set = table.CorrectionSet(entry);
+            correction_count = set[0];
+            corrections = set + 1;
+        }
+        // of all the subsets landing here, only the correction set itself is corrected right
+        ecc_syndrome correction_syndrome;
+        for (uint32_t ci = 0; ci < correction_count; ci++) {
+            correction_syndrome.w[0] ^= columns[corrections[ci]];
+        }
+        bool correctable_subset = correction_count == fail_count && correction_syndrome.w[0] == s;
+        result.stats.detection_corrected += count;
+        result.stats.false_corrections += count - (correctable_subset ? 1 : 0);
+        for (uint32_t ci = 0; ci < correction_count; ci++) {
+            uint32_t bit_pos = corrections[ci];
+            result.flip_occurence_counts[bit_pos] += count;
+            result.flip_occurence_flip_avg_distances[bit_pos] += (int64_t)((uint64_t)fail_count * bit_pos * count) - (int64_t)final_sums[s];
+        }
+    }
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+
+#include "analytic/analytic.hpp"
+#include "ecc/decode_table.hpp"
+#include "ecc/ecc.hpp"
+
+// the dp keeps a count and a position sum per syndrome for every layer 0..fail_count
+static const uint64_t SYNDROME_DP_MAX_BYTES = (uint64_t)1 << 30;
+
+// (fail_count + 1) * 2^k * 16 bytes
+uint64_t syndrome_dp_bytes(ECCMethod* method, uint32_t fail_count);
+
+// false if the fail_count-subsets of the word can not be counted in 64 bits or the layers exceed SYNDROME_DP_MAX_BYTES
+bool syndrome_dp_fits(ECCMethod* method, uint32_t fail_count);
+
+// exact full run over all fail_count-subsets of the word, a dp over the columns counts how many subsets land on every syndrome in O(n * fail_count * 2^k)
+// then the decode table turns the per syndrome counts into outcome totals, every layer is needed until the last column so they are updated in place
+void syndrome_dp_full_run(ECCMethod* method, const ECCDecodeTable& table, uint32_t fail_count, analytic_result& result);
@@ -0,0 +1,53 @@
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#include "util/combinations.hpp"
+
+#include "analytic/weight_spectrum.hpp"
+
+void sphere_outcomes_from_weights(uint32_t word_width, uint32_t padding_width, uint32_t radius, uint32_t fail_count,
+                                  const std::vector<std::vector<uint64_t>>& weights, analytic_result& result)
+{
+    assert(weights.size() == padding_width + 1);
+    result.stats = ecc_stats();
+    result.flip_occurence_counts.clear();
+    result.flip_occurence_flip_avg_distances.clear();
+
+    // the decoding spheres are disjoint, a pattern is corrected iff it lies at distance 1..radius of some codeword c
+    // the faults never touch the padding, so the b padding ones of c always count towards the distance, the rest is reached by clearing
+    // i of the w word ones of c and setting j of the n - w word zeros, with w - i + j = fail_count
+    const uint32_t n = word_width;
+    for (uint32_t b = 0; b <= padding_width && b <= radius; b++) {
+        const std::vector<uint64_t>& row = weights[b];
+        assert(row.size() > std::min(fail_count + radius, n));
+        if (b == 0) {
+            result.stats.detection_ok = row[fail_count];
+        }
+        for (uint32_t w = fail_count > radius ? fail_count - radius : 0; w <= fail_count + radius && w <= n; w++) {
+            if (row[w] == 0) {
+                continue;
+            }
+            uint64_t sphere_patterns = 0;
+            for (uint32_t distance = b == 0 ? 1 : 0; distance + b <= radius; distance++) {
+                int64_t twice_i = (int64_t)distance + w - fail_count;
+                if (twice_i < 0 || (twice_i & 0b1) != 0) {
+                    continue;
+                }
+                uint32_t i = twice_i / 2;
+                if (i > distance || i > w || distance - i > n - w) {
+                    continue;
+                }
+                uint32_t j = distance - i;
+                sphere_patterns += nCr(w, i) * nCr(n - w, j);
+            }
+            result.stats.detection_corrected += row[w] * sphere_patterns;
+            if (b > 0 || w > 0) {
+                // only the all zero codeword is the one the faults were injected into
+                result.stats.false_corrections += row[w] * sphere_patterns;
+            }
+        }
+    }
+    result.stats.detection_uncorrectable = nCr(n, fail_count) - result.stats.detection_ok - result.stats.detection_corrected;
+}
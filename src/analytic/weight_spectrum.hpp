@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "analytic/analytic.hpp"
+
+// exact outcome totals of a full random run with fail_count faults, for a bounded distance decoder of the given radius
+// weights[b][w] is the number of codewords with b ones in the decoder padding and w ones in the word, it needs padding_width + 1 rows
+// covering at least w <= fail_count + radius
+// per position flip occurences are not derivable from the weights, so those vectors stay empty
+void sphere_outcomes_from_weights(uint32_t word_width, uint32_t padding_width, uint32_t radius, uint32_t fail_count,
+                                  const std::vector<std::vector<uint64_t>>& weights, analytic_result& result);
@@ -3,27 +3,104 @@
 #include <cmath>
 #include <cstdio>
 #include <errno.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
 #include <vector>
 
 #include "bch_codec/bch_codec.h"
 
 #include "ecc.hpp"
+#include "clmul_encoder.hpp"
+#include "util/isa.hpp"
 
 #include "bch.hpp"
 
+static uint8_t bit_reverse_byte(uint8_t v)
+{
+    static const std::vector<uint8_t> table = []() {
+        std::vector<uint8_t> ret(256);
+        for (uint32_t i = 0; i < 256; i++) {
+            uint8_t r = 0;
+            for (uint32_t b = 0; b < 8; b++) {
+                r |= ((i >> b) & 0b1) << (7 - b);
+            }
+            ret[i] = r;
+        }
+        return ret;
+    }();
+    return table[v];
+}
+
+// the codec stores bits msb first per byte, packed words hold them lsb first
+static void pack_codec_bytes(const uint64_t* words, uint32_t bytes, uint8_t* out)
+{
+    for (uint32_t i = 0; i < bytes; i++) {
+        out[i] = bit_reverse_byte(words[i / 8] >> (8 * (i % 8)));
+    }
+}
+
+static void unpack_codec_bytes(const uint8_t* in, uint32_t bits, uint64_t* words)
+{
+    for (uint32_t i = 0; i < ecc_packed_words(bits); i++) {
+        words[i] = 0;
+    }
+    for (uint32_t i = 0; i < (bits + 7) / 8; i++) {
+        words[i / 8] |= (uint64_t)bit_reverse_byte(in[i]) << (8 * (i % 8));
+    }
+    if (bits % 64 != 0) {
+        words[bits / 64] &= ((uint64_t)1 << (bits % 64)) - 1;
+    }
+}
+
 ECCMethod_BCH::ECCMethod_BCH(uint32_t data_width, uint32_t correction_capability):
     data_width(data_width),
     correction_capability(correction_capability)
 {
+    // ctrl_data_width_bytes = (ctrl->n - ctrl->ecc_bits + 7) / 8;
+    ctrl_data_width_bytes = (data_width + 7) / 8;
+    // the padded data and the ecc together have to fit the code length, otherwise decode_bch reports locations past the word
     int m = ceil(log2(data_width + 1));
-    ctrl = init_bch(m, correction_capability, 0);
+    while (true) {
+        tables = SharedTables(m, correction_capability);
+        if (tables == NULL) {
+            printf("failed to initialize bch control\n");
+            assert(0);
+            exit(-1);
+        }
+        if (ctrl_data_width_bytes * 8 + tables->ecc_bits <= tables->n) {
+            break;
+        }
+        m++;
+    }
+    ctrl = init_bch_workspace(tables.get());
     if (ctrl == NULL) {
         printf("failed to initialize bch control\n");
         assert(0);
         exit(-1);
     }
-    // ctrl_data_width_bytes = (ctrl->n - ctrl->ecc_bits + 7) / 8;
-    ctrl_data_width_bytes = (data_width + 7) / 8;
+    if (isa_active() >= ISA_AVX2) {
+        // the ecc of the last padded data bit alone is x^r mod g, the generator without its leading term
+        std::vector<uint8_t> packed_data(ctrl_data_width_bytes, 0);
+        std::vector<uint8_t> packed_ecc(ctrl->ecc_bytes, 0);
+        std::vector<uint64_t> remainder(ecc_packed_words(ctrl->ecc_bits));
+        packed_data[ctrl_data_width_bytes - 1] = 1;
+        encode_bch(ctrl, packed_data.data(), ctrl_data_width_bytes, packed_ecc.data());
+        unpack_codec_bytes(packed_ecc.data(), ctrl->ecc_bits, remainder.data());
+        clmul.Build(ctrl_data_width_bytes * 8, ctrl->ecc_bits, remainder.data());
+    }
+    clmul_encoder = clmul.Built();
+    if (correction_capability > 4) {
+        // locators past degree 4 are factored by the codec, a search over a short enough codeword is cheaper
+        uint32_t codeword_width = ctrl_data_width_bytes * 8 + ctrl->ecc_bits;
+        chien.Build(tables.get(), codeword_width);
+        uint32_t max_bits_per_degree = isa_active() >= ISA_AVX2 ? CHIEN_SEARCH_MAX_BITS_PER_DEGREE_AVX2 : CHIEN_SEARCH_MAX_BITS_PER_DEGREE_SCALAR;
+        chien_default = codeword_width * ctrl->m <= max_bits_per_degree * correction_capability;
+    } else {
+        chien_default = false;
+    }
+    SetChienSearch(chien_default);
     // printf("bch init info:\n");
     // printf("\trequested data width b: %u\n", data_width);
     // printf("\trequested data width B: %u\n", ctrl_data_width_bytes);
@@ -38,9 +115,29 @@ ECCMethod_BCH::ECCMethod_BCH(uint32_t data_width, uint32_t correction_capability
 
 ECCMethod_BCH::~ECCMethod_BCH()
 {
+    // the tables go with the last instance using them
     free_bch(ctrl);
 }
 
+std::shared_ptr<bch_tables> ECCMethod_BCH::SharedTables(int m, uint32_t correction_capability)
+{
+    // every thread constructs its own method, only the first one of each code builds the tables
+    static std::mutex lock;
+    static std::map<std::pair<int, uint32_t>, std::weak_ptr<bch_tables>> cache;
+    std::lock_guard<std::mutex> guard(lock);
+    std::weak_ptr<bch_tables>& entry = cache[std::make_pair(m, correction_capability)];
+    std::shared_ptr<bch_tables> ret = entry.lock();
+    if (ret == NULL) {
+        bch_tables* built = init_bch_tables(m, correction_capability, 0);
+        if (built == NULL) {
+            return NULL;
+        }
+        ret = std::shared_ptr<bch_tables>(built, free_bch_tables);
+        entry = ret;
+    }
+    return ret;
+}
+
 uint32_t ECCMethod_BCH::DataWidth()
 {
     return data_width;
@@ -51,42 +148,135 @@ uint32_t ECCMethod_BCH::ECCWidth()
     return ctrl->ecc_bits;
 }
 
-void ECCMethod_BCH::ConstructECC(std::vector<bool>& data, std::vector<bool>& ecc)
+void ECCMethod_BCH::ConstructECCPacked(const uint64_t* data, uint64_t* ecc)
 {
-    std::vector<uint8_t> packed_data(ctrl_data_width_bytes, 0);
-    std::vector<uint8_t> packed_ecc(ctrl->ecc_bytes, 0);
+    if (clmul_encoder) {
+        clmul.Encode(data, ecc);
+        return;
+    }
+    uint8_t packed_data[ctrl_data_width_bytes];
+    uint8_t packed_ecc[ctrl->ecc_bytes];
+    pack_codec_bytes(data, ctrl_data_width_bytes, packed_data);
+    for (uint32_t i = 0; i < ctrl->ecc_bytes; i++) {
+        packed_ecc[i] = 0;
+    }
+    encode_bch(ctrl, packed_data, ctrl_data_width_bytes, packed_ecc);
+    unpack_codec_bytes(packed_ecc, ctrl->ecc_bits, ecc);
+}
 
-    // pack data into readable format for encode_bch
-    for (uint32_t i = 0; i < data_width; i++) {
-        packed_data[i / 8] |= data[i] << (7 - (i % 8));
+ECC_DETECTION ECCMethod_BCH::CheckAndCorrectPacked(uint64_t* data, uint64_t* ecc, uint32_t* corrections, uint32_t& correction_count)
+{
+    if (clmul_encoder) {
+        // the codec would encode the data again with its tables, it gets the syndrome instead
+        uint32_t ecc_words = ecc_packed_words(ctrl->ecc_bits);
+        uint64_t syndrome[ecc_words];
+        clmul.Encode(data, syndrome);
+        for (uint32_t wi = 0; wi < ecc_words; wi++) {
+            syndrome[wi] ^= ecc[wi];
+        }
+        ECC_DETECTION ret = DecodeSyndromeWords(syndrome, corrections, correction_count);
+        for (uint32_t ci = 0; ci < correction_count; ci++) {
+            uint32_t pos = corrections[ci];
+            if (pos < data_width) {
+                data[pos / 64] ^= (uint64_t)1 << (pos % 64);
+            } else {
+                ecc[(pos - data_width) / 64] ^= (uint64_t)1 << ((pos - data_width) % 64);
+            }
+        }
+        return ret;
     }
+    correction_count = 0;
+    uint8_t packed_data[ctrl_data_width_bytes];
+    uint8_t packed_ecc[ctrl->ecc_bytes];
+    pack_codec_bytes(data, ctrl_data_width_bytes, packed_data);
+    pack_codec_bytes(ecc, ctrl->ecc_bytes, packed_ecc);
 
-    // encode
-    encode_bch(ctrl, packed_data.data(), ctrl_data_width_bytes, packed_ecc.data());
+    // decode
+    unsigned int err_locations[correction_capability];
+    int err_num = decode_bch(ctrl, packed_data, ctrl_data_width_bytes, packed_ecc, NULL, NULL, err_locations);
 
-    // output ecc
-    for (uint32_t i = 0; i < ctrl->ecc_bits; i++) {
-        ecc[i] = (packed_ecc[i / 8] >> (7 - (i % 8))) & 0b1;
+    if (err_num == -EINVAL) {
+        printf("bch message decoding parameters invalid\n");
+        assert(0);
+        exit(-1);
+    } else if (err_num == -EBADMSG) {
+        return ECC_DETECTION_UNCORRECTABLE;
+    } else if (err_num == 0) {
+        return ECC_DETECTION_OK;
+    }
+
+    // correct faults by flipping the located bits, the corrected word is a codeword so its ecc part needs no recomputation
+    // locations in the data padding only flip bits that are not stored
+    for (int i = 0; i < err_num; i++) {
+        uint32_t loc = (err_locations[i] & ~7) | (7 - (err_locations[i] & 7));
+        if (loc < data_width) {
+            data[loc / 64] ^= (uint64_t)1 << (loc % 64);
+            corrections[correction_count++] = loc;
+        } else if (loc >= ctrl_data_width_bytes * 8) {
+            uint32_t ecc_idx = loc - ctrl_data_width_bytes * 8;
+            ecc[ecc_idx / 64] ^= (uint64_t)1 << (ecc_idx % 64);
+            corrections[correction_count++] = data_width + ecc_idx;
+        }
     }
+
+    return ECC_DETECTION_CORRECTED;
+}
+
+uint32_t ECCMethod_BCH::CorrectionCapability()
+{
+    return correction_capability;
+}
+
+bool ECCMethod_BCH::BoundedDistance()
+{
+    // over the word extended by the byte padding of the data
+    return true;
 }
 
-ECC_DETECTION ECCMethod_BCH::CheckAndCorrect(std::vector<bool>& data, std::vector<bool>& ecc)
+uint32_t ECCMethod_BCH::PaddingWidth()
 {
+    return ctrl_data_width_bytes * 8 - data_width;
+}
+
+ecc_syndrome ECCMethod_BCH::ColumnSyndrome(uint32_t position)
+{
+    ecc_syndrome ret;
+    assert(ctrl->ecc_bits <= ECC_SYNDROME_MAX_BITS);
+    if (position >= data_width && position < data_width + ctrl->ecc_bits) {
+        ret.flip(position - data_width);
+        return ret;
+    }
+    // data and padding bits share the packed data layout, padding follows the data there
+    uint32_t data_pos = position < data_width ? position : position - ctrl->ecc_bits;
+    assert(data_pos < ctrl_data_width_bytes * 8);
     std::vector<uint8_t> packed_data(ctrl_data_width_bytes, 0);
     std::vector<uint8_t> packed_ecc(ctrl->ecc_bytes, 0);
+    packed_data[data_pos / 8] = 1 << (7 - (data_pos % 8));
+    encode_bch(ctrl, packed_data.data(), ctrl_data_width_bytes, packed_ecc.data());
+    unpack_codec_bytes(packed_ecc.data(), ctrl->ecc_bits, ret.w);
+    return ret;
+}
 
-    // pack inputs into readable format for decode_bch
-    for (uint32_t i = 0; i < data_width; i++) {
-        packed_data[i / 8] |= data[i] << (7 - (i % 8));
-    }
-    for (uint32_t i = 0; i < ctrl->ecc_bits; i++) {
-        packed_ecc[i / 8] |= ecc[i] << (7 - (i % 8));
-    }
+ECC_DETECTION ECCMethod_BCH::DecodeSyndrome(const ecc_syndrome& syndrome, uint32_t* corrections, uint32_t& correction_count)
+{
+    assert(ctrl->ecc_bits <= ECC_SYNDROME_MAX_BITS);
+    return DecodeSyndromeWords(syndrome.w, corrections, correction_count);
+}
 
-    // decode
-    std::vector<uint32_t> err_locations(correction_capability, 0);
-    int err_num = decode_bch(ctrl, packed_data.data(), ctrl_data_width_bytes, packed_ecc.data(), NULL, NULL, err_locations.data());
+ECC_DETECTION ECCMethod_BCH::DecodeSyndromeWords(const uint64_t* syndrome, uint32_t* corrections, uint32_t& correction_count)
+{
+    // the syndrome is exactly recv_ecc xor calc_ecc, which decode_bch accepts directly without touching the data
+    uint8_t packed_ecc[ctrl->ecc_bytes];
+    pack_codec_bytes(syndrome, ctrl->ecc_bytes, packed_ecc);
 
+    unsigned int err_locations[correction_capability];
+    int err_num = decode_bch(ctrl, NULL, ctrl_data_width_bytes, NULL, packed_ecc, NULL, err_locations);
+    return TranslateLocations(err_num, err_locations, corrections, correction_count);
+}
+
+ECC_DETECTION ECCMethod_BCH::TranslateLocations(int err_num, const unsigned int* err_locations, uint32_t* corrections, uint32_t& correction_count)
+{
+    correction_count = 0;
     if (err_num == -EINVAL) {
         printf("bch message decoding parameters invalid\n");
         assert(0);
@@ -97,28 +287,100 @@ ECC_DETECTION ECCMethod_BCH::CheckAndCorrect(std::vector<bool>& data, std::vecto
         return ECC_DETECTION_OK;
     }
 
-    // printf("detected %i correctable error%s at:", err_num, err_num > 1 ? "s" : "");
-    // for (int i = 0; i < err_num; i++) {
-    //     printf(" %u", ((err_locations[i] / 8) * 8) + (7 - (err_locations[i] % 8)));
-    //     if (i + 1 < err_num) {
-    //         printf(",");
-    //     }
-    // }
-    // printf("\n");
+    // undo the per byte bit reversal of decode_bch, locations in the data padding are corrected invisibly by CheckAndCorrectPacked
+    for (int i = 0; i < err_num; i++) {
+        uint32_t loc = (err_locations[i] & ~7) | (7 - (err_locations[i] & 7));
+        if (loc < data_width) {
+            corrections[correction_count++] = loc;
+        } else if (loc >= ctrl_data_width_bytes * 8) {
+            corrections[correction_count++] = data_width + loc - ctrl_data_width_bytes * 8;
+        }
+    }
+    return ECC_DETECTION_CORRECTED;
+}
 
-    // correct faults
-    correct_bch(ctrl, packed_data.data(), ctrl_data_width_bytes, err_locations.data(), err_num);
-    // recalc ecc part to fix possible ecc faults
-    packed_ecc.assign(ctrl->ecc_bytes, 0);
-    encode_bch(ctrl, packed_data.data(), ctrl_data_width_bytes, packed_ecc.data()); // could flip instead of recomputing
+uint32_t ECCMethod_BCH::PowerSyndromeWidth()
+{
+    // S_1, S_3, .. S_(2t-1) in 16 bit fields, the even power sums are their squares
+    return correction_capability * 16 <= ECC_SYNDROME_MAX_BITS ? correction_capability * 16 : 0;
+}
 
-    // output packed and corrected inputs
-    for (uint32_t i = 0; i < data_width; i++) {
-        data[i] = (packed_data[i / 8] >> (7 - (i % 8))) & 0b1;
+ecc_syndrome ECCMethod_BCH::PowerColumn(uint32_t position)
+{
+    // a flip at codeword degree e adds a^(j e) to S_j, the data precedes the ecc in the codec's polynomial, highest degree first
+    assert(PowerSyndromeWidth() > 0);
+    uint32_t degree;
+    if (position >= data_width && position < data_width + ctrl->ecc_bits) {
+        degree = ctrl->ecc_bits - 1 - (position - data_width);
+    } else {
+        uint32_t data_pos = position < data_width ? position : position - ctrl->ecc_bits;
+        assert(data_pos < ctrl_data_width_bytes * 8);
+        degree = ctrl->ecc_bits + ctrl_data_width_bytes * 8 - 1 - data_pos;
     }
-    for (uint32_t i = 0; i < ctrl->ecc_bits; i++) {
-        ecc[i] = (packed_ecc[i / 8] >> (7 - (i % 8))) & 0b1;
+    ecc_syndrome ret;
+    for (uint32_t i = 0; i < correction_capability; i++) {
+        uint64_t power = ctrl->a_pow_tab[((uint64_t)(2 * i + 1) * degree) % ctrl->n];
+        ret.w[i / 4] |= power << (16 * (i % 4));
     }
+    return ret;
+}
 
-    return ECC_DETECTION_CORRECTED;
+ECC_DETECTION ECCMethod_BCH::DecodePowerSyndrome(const ecc_syndrome& syndrome, uint32_t* corrections, uint32_t& correction_count)
+{
+    // decode_bch takes all 2t power sums and skips computing them from the ecc
+    unsigned int syn[2 * correction_capability];
+    for (uint32_t i = 0; i < correction_capability; i++) {
+        syn[2 * i] = (syndrome.w[i / 4] >> (16 * (i % 4))) & 0xFFFF;
+    }
+    for (uint32_t i = 0; i < correction_capability; i++) {
+        syn[2 * i + 1] = syn[i] == 0 ? 0 : ctrl->a_pow_tab[(2 * ctrl->a_log_tab[syn[i]]) % ctrl->n];
+    }
+    unsigned int err_locations[correction_capability];
+    int err_num = decode_bch(ctrl, NULL, ctrl_data_width_bytes, NULL, NULL, syn, err_locations);
+    return TranslateLocations(err_num, err_locations, corrections, correction_count);
+}
+
+uint32_t ECCMethod_BCH::EncoderVariantCount()
+{
+    // carry-less multiplies if built, codec tables
+    return clmul.Built() ? 2 : 1;
+}
+
+const char* ECCMethod_BCH::EncoderVariantName(uint32_t variant)
+{
+    return clmul.Built() && variant == 0 ? "clmul" : "table";
+}
+
+void ECCMethod_BCH::SetEncoderVariant(uint32_t variant)
+{
+    assert(variant < EncoderVariantCount());
+    clmul_encoder = clmul.Built() && variant == 0;
+}
+
+uint32_t ECCMethod_BCH::DecoderVariantCount()
+{
+    // root search if built, either way around
+    return chien.Built() ? 2 : 1;
+}
+
+const char* ECCMethod_BCH::DecoderVariantName(uint32_t variant)
+{
+    return chien.Built() && (variant == 0) == chien_default ? "chien" : "factor";
+}
+
+void ECCMethod_BCH::SetDecoderVariant(uint32_t variant)
+{
+    assert(variant < DecoderVariantCount());
+    SetChienSearch((variant == 0) == chien_default);
+}
+
+void ECCMethod_BCH::SetClosedForm(bool closed_form)
+{
+    ctrl->closed_form = closed_form && tables->deg2_tab != NULL;
+}
+
+void ECCMethod_BCH::SetChienSearch(bool chien_search)
+{
+    ctrl->root_search = chien_search && chien.Built() ? ECCChienSearch::RootSearch : NULL;
+    ctrl->root_search_context = &chien;
 }
@@ -1,23 +1,39 @@
 #pragma once
 
 #include <cstdint>
+#include <memory>
 #include <vector>
 
 #include "bch_codec/bch_codec.h"
 
 #include "ecc.hpp"
+#include "chien_search.hpp"
+#include "clmul_encoder.hpp"
 
 class ECCMethod_BCH : public ECCMethod {
     // generic BCH wrapper
 
   private:
 
-    bch_control* ctrl;
+    std::shared_ptr<bch_tables> tables; // shared by every instance of the same m and t
+    bch_control* ctrl; // per instance workspace over the tables
 
     uint32_t data_width;
     uint32_t ctrl_data_width_bytes;
     uint32_t correction_capability;
 
+    ECCClmulEncoder clmul; // only built if the host has carry-less multiplies, the codec tables cover the rest
+    bool clmul_encoder; // encode through clmul instead of the codec tables
+    ECCChienSearch chien; // only built for t > 4
+    bool chien_default; // decoder variant 0 searches the roots, picked by the codeword length and the isa
+
+    static std::shared_ptr<bch_tables> SharedTables(int m, uint32_t correction_capability);
+
+    // ecc_bits syndrome words, corrections in method positions
+    ECC_DETECTION DecodeSyndromeWords(const uint64_t* syndrome, uint32_t* corrections, uint32_t& correction_count);
+    // outcome of decode_bch with its locations translated to method positions
+    ECC_DETECTION TranslateLocations(int err_num, const unsigned int* err_locations, uint32_t* corrections, uint32_t& correction_count);
+
   public:
 
     ECCMethod_BCH(uint32_t data_width, uint32_t correction_capability);
@@ -25,6 +41,26 @@ class ECCMethod_BCH : public ECCMethod {
 
     uint32_t DataWidth() override;
     uint32_t ECCWidth() override;
-    void ConstructECC(std::vector<bool>& data, std::vector<bool>& ecc) override;
-    ECC_DETECTION CheckAndCorrect(std::vector<bool>& data, std::vector<bool>& ecc) override;
+    void ConstructECCPacked(const uint64_t* data, uint64_t* ecc) override;
+    ECC_DETECTION CheckAndCorrectPacked(uint64_t* data, uint64_t* ecc, uint32_t* corrections, uint32_t& correction_count) override;
+    uint32_t CorrectionCapability() override;
+    bool BoundedDistance() override;
+    uint32_t PaddingWidth() override;
+    ecc_syndrome ColumnSyndrome(uint32_t position) override;
+    ECC_DETECTION DecodeSyndrome(const ecc_syndrome& syndrome, uint32_t* corrections, uint32_t& correction_count) override;
+    uint32_t PowerSyndromeWidth() override;
+    ecc_syndrome PowerColumn(uint32_t position) override;
+    ECC_DETECTION DecodePowerSyndrome(const ecc_syndrome& syndrome, uint32_t* corrections, uint32_t& correction_count) override;
+    uint32_t EncoderVariantCount() override;
+    const char* EncoderVariantName(uint32_t variant) override;
+    void SetEncoderVariant(uint32_t variant) override;
+    uint32_t DecoderVariantCount() override;
+    const char* DecoderVariantName(uint32_t variant) override;
+    void SetDecoderVariant(uint32_t variant) override;
+
+    // decode t <= BCH_CLOSED_FORM_MAX_T through the closed forms, the default, or through berlekamp-massey and the root search
+    void SetClosedForm(bool closed_form);
+    // find the roots of locators past degree 4 by the chien search or by factoring them, the default depends on the codeword length
+    // and the isa, the decoder variants are the two choices with the default first
+    void SetChienSearch(bool chien_search);
 };
@@ -0,0 +1,172 @@
+#include <cassert>
+#include <cstdint>
+#include <immintrin.h>
+#include <vector>
+
+#include "bch_codec/bch_codec.h"
+#include "util/isa.hpp"
+
+#include "chien_search.hpp"
+
+static const uint32_t CHIEN_MAX_M = 16;
+static const uint32_t CHIEN_LANE_WORDS = ECCChienSearch::BLOCK_LANES / 64;
+
+ECCChienSearch::ECCChienSearch()
+{
+}
+
+ECCChienSearch::~ECCChienSearch()
+{
+}
+
+void ECCChienSearch::Build(const bch_tables* tables, uint32_t length)
+{
+    assert(tables->m <= CHIEN_MAX_M);
+    assert(length > 0 && length <= tables->n);
+    m = tables->m;
+    n = tables->n;
+    this->length = length;
+    max_degree = tables->t;
+    a_pow_tab = tables->a_pow_tab;
+    a_log_tab = tables->a_log_tab;
+
+    planes.assign((size_t)max_degree * m * m * CHIEN_LANE_WORDS, 0);
+    for (uint32_t j = 1; j <= max_degree; j++) {
+        for (uint32_t lane = 0; lane < BLOCK_LANES; lane++) {
+            uint32_t lane_log = n - (uint32_t)(((uint64_t)j * lane) % n);
+            for (uint32_t b = 0; b < m; b++) {
+                uint32_t value = a_pow_tab[(b + lane_log) % n];
+                uint64_t* bit_planes = &planes[((size_t)(j - 1) * m + b) * m * CHIEN_LANE_WORDS];
+                for (uint32_t p = 0; p < m; p++) {
+                    bit_planes[p * CHIEN_LANE_WORDS + lane / 64] |= (uint64_t)((value >> p) & 0b1) << (lane % 64);
+                }
+            }
+        }
+    }
+    log_steps.assign(max_degree + 1, 0);
+    for (uint32_t j = 1; j <= max_degree; j++) {
+        log_steps[j] = (uint32_t)(((uint64_t)BLOCK_LANES * j) % n);
+    }
+    log_d.assign(max_degree + 1, 0);
+    // a single block is searched faster without the wide registers
+    avx2 = isa_active() >= ISA_AVX2 && length > BLOCK_LANES;
+}
+
+bool ECCChienSearch::Built() const
+{
+    return length > 0;
+}
+
+// lanes of the block starting at position first that lie within the length
+static inline uint64_t chien_valid_lanes(uint32_t first, uint32_t length)
+{
+    return first >= length ? 0 : length - first >= 64 ? ~(uint64_t)0 : ((uint64_t)1 << (length - first)) - 1;
+}
+
+int ECCChienSearch::Find(const unsigned int* c, unsigned int deg, unsigned int* roots) const
+{
+    assert(deg <= max_degree);
+    if (avx2) {
+        return FindAVX2(c, deg, roots);
+    }
+    for (uint32_t j = 1; j <= deg; j++) {
+        log_d[j] = c[j] == 0 ? n : a_log_tab[c[j]];
+    }
+    int count = 0;
+    uint64_t acc[CHIEN_MAX_M][CHIEN_LANE_WORDS];
+    for (uint32_t first = 0; first < length; first += BLOCK_LANES) {
+        for (uint32_t p = 0; p < m; p++) {
+            for (uint32_t lw = 0; lw < CHIEN_LANE_WORDS; lw++) {
+                acc[p][lw] = ((c[0] >> p) & 0b1) ? ~(uint64_t)0 : 0;
+            }
+        }
+        for (uint32_t j = 1; j <= deg; j++) {
+            if (log_d[j] == n) {
+                continue;
+            }
+            uint32_t d = a_pow_tab[log_d[j]];
+            log_d[j] = log_d[j] >= log_steps[j] ? log_d[j] - log_steps[j] : log_d[j] + n - log_steps[j];
+            const uint64_t* term_planes = &planes[(size_t)(j - 1) * m * m * CHIEN_LANE_WORDS];
+            while (d != 0) {
+                const uint64_t* bit_planes = &term_planes[__builtin_ctz(d) * m * CHIEN_LANE_WORDS];
+                d &= d - 1;
+                for (uint32_t p = 0; p < m; p++) {
+                    for (uint32_t lw = 0; lw < CHIEN_LANE_WORDS; lw++) {
+                        acc[p][lw] ^= bit_planes[p * CHIEN_LANE_WORDS + lw];
+                    }
+                }
+            }
+        }
+        for (uint32_t lw = 0; lw < CHIEN_LANE_WORDS; lw++) {
+            uint64_t nonzero = 0;
+            for (uint32_t p = 0; p < m; p++) {
+                nonzero |= acc[p][lw];
+            }
+            uint64_t zeros = ~nonzero & chien_valid_lanes(first + lw * 64, length);
+            while (zeros != 0) {
+                roots[count++] = first + lw * 64 + __builtin_ctzll(zeros);
+                if (count == (int)deg) {
+                    return count;
+                }
+                zeros &= zeros - 1;
+            }
+        }
+    }
+    return count;
+}
+
+ISA_TARGET_AVX2 int ECCChienSearch::FindAVX2(const unsigned int* c, unsigned int deg, unsigned int* roots) const
+{
+    // the scalar search with a plane in one register
+    for (uint32_t j = 1; j <= deg; j++) {
+        log_d[j] = c[j] == 0 ? n : a_log_tab[c[j]];
+    }
+    const __m256i ones = _mm256_set1_epi64x(-1);
+    int count = 0;
+    __m256i acc[CHIEN_MAX_M];
+    for (uint32_t first = 0; first < length; first += BLOCK_LANES) {
+        for (uint32_t p = 0; p < m; p++) {
+            acc[p] = ((c[0] >> p) & 0b1) ? ones : _mm256_setzero_si256();
+        }
+        for (uint32_t j = 1; j <= deg; j++) {
+            if (log_d[j] == n) {
+                continue;
+            }
+            uint32_t d = a_pow_tab[log_d[j]];
+            log_d[j] = log_d[j] >= log_steps[j] ? log_d[j] - log_steps[j] : log_d[j] + n - log_steps[j];
+            const uint64_t* term_planes = &planes[(size_t)(j - 1) * m * m * CHIEN_LANE_WORDS];
+            while (d != 0) {
+                const uint64_t* bit_planes = &term_planes[__builtin_ctz(d) * m * CHIEN_LANE_WORDS];
+                d &= d - 1;
+                for (uint32_t p = 0; p < m; p++) {
+                    acc[p] = _mm256_xor_si256(acc[p], _mm256_loadu_si256((const __m256i*)&bit_planes[p * CHIEN_LANE_WORDS]));
+                }
+            }
+        }
+        __m256i nonzero = acc[0];
+        for (uint32_t p = 1; p < m; p++) {
+            nonzero = _mm256_or_si256(nonzero, acc[p]);
+        }
+        if (_mm256_testc_si256(nonzero, ones)) {
+            continue;
+        }
+        uint64_t lanes[CHIEN_LANE_WORDS];
+        _mm256_storeu_si256((__m256i*)lanes, nonzero);
+        for (uint32_t lw = 0; lw < CHIEN_LANE_WORDS; lw++) {
+            uint64_t zeros = ~lanes[lw] & chien_valid_lanes(first + lw * 64, length);
+            while (zeros != 0) {
+                roots[count++] = first + lw * 64 + __builtin_ctzll(zeros);
+                if (count == (int)deg) {
+                    return count;
+                }
+                zeros &= zeros - 1;
+            }
+        }
+    }
+    return count;
+}
+
+int ECCChienSearch::RootSearch(void* context, const unsigned int* c, unsigned int deg, unsigned int* roots)
+{
+    return ((const ECCChienSearch*)context)->Find(c, deg, roots);
+}
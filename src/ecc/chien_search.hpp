@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "bch_codec/bch_codec.h"
+
+// past this many searched position bits, length times m, per locator degree factoring the locator is faster than the search, main
+// benchmarks both for long runs
+// bench_bch_root_search over t 5..40 and 64..8000 data bits puts the crossover near 1100..1500 scalar and 2000..3000 with avx2, a
+// codeword of one 256 lane block is searched scalar on every host
+static const uint32_t CHIEN_SEARCH_MAX_BITS_PER_DEGREE_SCALAR = 1024;
+static const uint32_t CHIEN_SEARCH_MAX_BITS_PER_DEGREE_AVX2 = 2048;
+
+class ECCChienSearch {
+    // exhaustive root search of bch error locators over the shortened codeword, bit-sliced: bit p of the field elements of 256
+    // consecutive positions is held in plane p of 256 lanes, so adding a constant plane to all of them takes one xor
+    // position e = 256 block + l evaluates sum_j c_j a^(-j e) = sum_j d_j a^(-j l) with d_j = c_j a^(-256 j block), the planes of
+    // a^b a^(-j l) are precomputed for every bit b, so every term costs m plane xors per set bit of d_j
+
+  private:
+
+    uint32_t m = 0;
+    uint32_t n = 0;
+    uint32_t length = 0; // positions searched, data and ecc bits of the shortened codeword
+    uint32_t max_degree = 0;
+    const uint16_t* a_pow_tab = nullptr;
+    const uint16_t* a_log_tab = nullptr;
+    std::vector<uint64_t> planes; // [degree - 1][bit][plane][lane word]
+    std::vector<uint32_t> log_steps; // 256 j mod n, what log_d of degree j drops per block
+    mutable std::vector<uint32_t> log_d; // log of d_j in the current block, n for a zero coefficient, scratch of Find
+    bool avx2 = false;
+
+    int FindAVX2(const unsigned int* c, unsigned int deg, unsigned int* roots) const;
+
+  public:
+
+    static const uint32_t BLOCK_LANES = 256;
+
+    ECCChienSearch();
+    ~ECCChienSearch();
+
+    // the tables must outlive the search, locators up to degree t
+    void Build(const bch_tables* tables, uint32_t length);
+    bool Built() const;
+
+    // distinct roots e of c[0] + c[1] x + .. + c[deg] x^deg as in x = a^(-e) for e below the length, stops after deg roots, not
+    // thread safe
+    int Find(const unsigned int* c, unsigned int deg, unsigned int* roots) const;
+
+    // root_search hook of bch_control with the search as its context
+    static int RootSearch(void* context, const unsigned int* c, unsigned int deg, unsigned int* roots);
+};
@@ -0,0 +1,101 @@
+#include <cassert>
+#include <cstdint>
+#include <immintrin.h>
+#include <vector>
+
+#include "ecc.hpp"
+#include "util/isa.hpp"
+
+#include "clmul_encoder.hpp"
+
+static ISA_INLINE uint64_t bit_reverse(uint64_t v)
+{
+    v = __builtin_bswap64(v);
+    v = ((v >> 4) & 0x0F0F0F0F0F0F0F0F) | ((v & 0x0F0F0F0F0F0F0F0F) << 4);
+    v = ((v >> 2) & 0x3333333333333333) | ((v & 0x3333333333333333) << 2);
+    v = ((v >> 1) & 0x5555555555555555) | ((v & 0x5555555555555555) << 1);
+    return v;
+}
+
+ECCClmulEncoder::ECCClmulEncoder()
+{
+}
+
+ECCClmulEncoder::~ECCClmulEncoder()
+{
+}
+
+void ECCClmulEncoder::Build(uint32_t data_width, uint32_t ecc_width, const uint64_t* remainder)
+{
+    assert(data_width > 0 && ecc_width > 0);
+    this->data_width = data_width;
+    data_words = ecc_packed_words(data_width);
+    ecc_words = ecc_packed_words(ecc_width);
+    lead_shift = data_words * 64 - data_width;
+    last_word_mask = data_width % 64 == 0 ? ~(uint64_t)0 : ((uint64_t)1 << (data_width % 64)) - 1;
+
+    // ecc bit j is the coefficient of x^(r - 1 - j), which lands on bit 64 ecc_words - 1 - j of the scaled generator
+    generator.assign(ecc_words, 0);
+    for (uint32_t wi = 0; wi < ecc_words; wi++) {
+        generator[ecc_words - 1 - wi] = bit_reverse(remainder[wi]);
+    }
+
+    // long division of x^(64 ecc_words + 64), the quotient has degree 64 and its top bit is implied
+    uint32_t top = ecc_words * 64;
+    std::vector<uint64_t> dividend(ecc_words + 2, 0);
+    dividend[(top + 64) / 64] |= (uint64_t)1 << ((top + 64) % 64);
+    barrett = 0;
+    for (uint32_t deg = top + 64; deg >= top; deg--) {
+        if (((dividend[deg / 64] >> (deg % 64)) & 0b1) == 0) {
+            continue;
+        }
+        uint32_t shift = deg - top;
+        if (shift < 64) {
+            barrett |= (uint64_t)1 << shift;
+        }
+        dividend[deg / 64] ^= (uint64_t)1 << (deg % 64);
+        for (uint32_t bit = 0; bit < top; bit++) {
+            if ((generator[bit / 64] >> (bit % 64)) & 0b1) {
+                dividend[(bit + shift) / 64] ^= (uint64_t)1 << ((bit + shift) % 64);
+            }
+        }
+    }
+}
+
+bool ECCClmulEncoder::Built() const
+{
+    return data_words > 0;
+}
+
+ISA_TARGET_AVX2 void ECCClmulEncoder::Encode(const uint64_t* data, uint64_t* ecc) const
+{
+    uint64_t state[ecc_words];
+    for (uint32_t wi = 0; wi < ecc_words; wi++) {
+        state[wi] = 0;
+    }
+    const __m128i mu = _mm_cvtsi64_si128(barrett);
+    uint64_t previous = 0;
+    for (uint32_t dwi = 0; dwi < data_words; dwi++) {
+        // 64 data bits from the highest coefficient on, the data is shifted down so the last bit ends a word
+        uint64_t reversed = bit_reverse(dwi + 1 == data_words ? data[dwi] & last_word_mask : data[dwi]);
+        uint64_t chunk = lead_shift == 0 ? reversed : (reversed >> lead_shift) | (previous << (64 - lead_shift));
+        previous = reversed;
+
+        uint64_t folded = state[ecc_words - 1] ^ chunk;
+        for (uint32_t wi = ecc_words - 1; wi > 0; wi--) {
+            state[wi] = state[wi - 1];
+        }
+        state[0] = 0;
+        __m128i quotient = _mm_cvtsi64_si128(folded ^ _mm_extract_epi64(_mm_clmulepi64_si128(_mm_cvtsi64_si128(folded), mu, 0x00), 1));
+        for (uint32_t wi = 0; wi < ecc_words; wi++) {
+            __m128i product = _mm_clmulepi64_si128(quotient, _mm_cvtsi64_si128(generator[wi]), 0x00);
+            state[wi] ^= _mm_cvtsi128_si64(product);
+            if (wi + 1 < ecc_words) {
+                state[wi + 1] ^= _mm_extract_epi64(product, 1);
+            }
+        }
+    }
+    for (uint32_t wi = 0; wi < ecc_words; wi++) {
+        ecc[wi] = bit_reverse(state[ecc_words - 1 - wi]);
+    }
+}
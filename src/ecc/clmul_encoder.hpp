@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+class ECCClmulEncoder {
+    // remainder of a cyclic code by carry-less multiplies: the data polynomial, data bit 0 being its highest coefficient, times
+    // x^r modulo the generator of degree r, with ecc bit 0 the highest coefficient of the remainder, as the bch codec orders them
+    // the generator is scaled by x^pad to a whole number of words and 64 data bits are folded in per step, the quotient of the
+    // folded top word comes from a barrett multiply with floor(x^(64 words + 64) / generator) and its product with the generator
+    // clears it again
+
+  private:
+
+    uint32_t data_width = 0; // bits the codec reads, a whole number of bytes
+    uint32_t data_words = 0;
+    uint32_t ecc_words = 0;
+    uint32_t lead_shift = 0; // leading zero bits that align the last data bit to the end of a word
+    uint64_t last_word_mask = 0;
+    std::vector<uint64_t> generator; // generator minus its leading term, times x^pad, lowest word first
+    uint64_t barrett = 0; // floor(x^(64 ecc_words + 64) / scaled generator) minus its leading term x^64
+
+  public:
+
+    ECCClmulEncoder();
+    ~ECCClmulEncoder();
+
+    // remainder holds the ecc of the lowest coefficient alone, which is the generator minus its leading term
+    void Build(uint32_t data_width, uint32_t ecc_width, const uint64_t* remainder);
+    bool Built() const;
+
+    // needs ISA_AVX2, ecc is fully overwritten
+    void Encode(const uint64_t* data, uint64_t* ecc) const;
+};
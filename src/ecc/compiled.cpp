@@ -0,0 +1,356 @@
+#include <cassert>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <dlfcn.h>
+#include <map>
+#include <string>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+#include "ecc.hpp"
+#include "decode_table.hpp"
+#include "util/isa.hpp"
+
+#include "compiled.hpp"
+
+// target flags of the kernels for every isa level, the same extensions as the ISA_TARGET attributes
+static const char* COMPILED_ISA_FLAGS[ISA_COUNT] = {
+    "",
+    "-msse4.2 -mpopcnt",
+    "-msse4.2 -mpopcnt -mavx2 -mpclmul",
+    "-msse4.2 -mpopcnt -mavx2 -mpclmul -mavx512f -mavx512bw -mavx512vl -mavx512vpopcntdq",
+    "-msse4.2 -mpopcnt -mavx2 -mpclmul -mavx512f -mavx512bw -mavx512vl -mavx512vpopcntdq -mgfni",
+};
+
+// single quoted for the shell
+static std::string shell_quote(const std::string& word)
+{
+    std::string quoted = "'";
+    for (char c : word) {
+        quoted += c == '\'' ? std::string("'\\''") : std::string(1, c);
+    }
+    return quoted + "'";
+}
+
+ECCMethod_Compiled::ECCMethod_Compiled(ECCMethod* base, void* library):
+    base(base),
+    compiled_encoder(true)
+{
+    encode = (encode_function)dlsym(library, "ecc_encode");
+    encode_batch = (encode_batch_function)dlsym(library, "ecc_encode_batch");
+    entries = (const uint32_t*)dlsym(library, "ecc_entries");
+    assert(encode != NULL && encode_batch != NULL);
+}
+
+ECCMethod_Compiled::~ECCMethod_Compiled()
+{
+    // the library stays loaded, it is shared by every instance of the same matrix
+    delete base;
+}
+
+bool ECCMethod_Compiled::Fits(ECCMethod* method)
+{
+    return method->ECCWidth() <= ECC_SYNDROME_MAX_BITS && method->PaddingWidth() == 0;
+}
+
+ECCMethod_Compiled* ECCMethod_Compiled::Create(ECCMethod* base)
+{
+    assert(Fits(base));
+    void* library = LoadLibrary(GenerateSource(base));
+    if (library == NULL) {
+        return NULL;
+    }
+    return new ECCMethod_Compiled(base, library);
+}
+
+std::string ECCMethod_Compiled::GenerateSource(ECCMethod* method)
+{
+    uint32_t data_width = method->DataWidth();
+    uint32_t ecc_width = method->ECCWidth();
+    uint32_t data_words = ecc_packed_words(data_width);
+    uint32_t ecc_words = ecc_packed_words(ecc_width);
+
+    // data part of every parity row, [row][data word]
+    std::vector<uint64_t> rows(ecc_width * data_words, 0);
+    for (uint32_t bit_pos = 0; bit_pos < data_width; bit_pos++) {
+        ecc_syndrome column = method->ColumnSyndrome(bit_pos);
+        for (uint32_t ri = 0; ri < ecc_width; ri++) {
+            if (column.get(ri)) {
+                rows[ri * data_words + bit_pos / 64] |= (uint64_t)1 << (bit_pos % 64);
+            }
+        }
+    }
+
+    std::string source;
+    char line[256];
+    source += "#include <stdint.h>\n\n";
+    source += "static inline __attribute__((always_inline)) void encode_strided(const uint64_t* d, uint64_t* e, uint64_t stride)\n{\n";
+    for (uint32_t wi = 0; wi < data_words; wi++) {
+        snprintf(line, sizeof(line), "    const uint64_t d%u = d[%u * stride];\n", wi, wi);
+        source += line;
+    }
+    for (uint32_t ewi = 0; ewi < ecc_words; ewi++) {
+        snprintf(line, sizeof(line), "    uint64_t e%u = 0;\n", ewi);
+        source += line;
+        for (uint32_t ri = ewi * 64; ri < ecc_width && ri < (ewi + 1) * 64; ri++) {
+            std::string tree;
+            for (uint32_t wi = 0; wi < data_words; wi++) {
+                uint64_t mask = rows[ri * data_words + wi];
+                if (mask == 0) {
+                    continue;
+                }
+                snprintf(line, sizeof(line), "%s(d%u & 0x%016" PRIx64 "ull)", tree.empty() ? "" : " ^ ", wi, mask);
+                tree += line;
+            }
+            if (tree.empty()) {
+                continue;
+            }
+            snprintf(line, sizeof(line), "    e%u |= (uint64_t)__builtin_parityll(", ewi);
+            source += line + tree;
+            snprintf(line, sizeof(line), ") << %u;\n", ri % 64);
+            source += line;
+        }
+        snprintf(line, sizeof(line), "    e[%u * stride] = e%u;\n", ewi, ewi);
+        source += line;
+    }
+    source += "}\n\n";
+    source += "void ecc_encode(const uint64_t* d, uint64_t* e)\n{\n    encode_strided(d, e, 1);\n}\n\n";
+    source += "void ecc_encode_batch(const uint64_t* d, uint64_t* e, uint32_t count)\n{\n";
+    source += "    for (uint32_t c = 0; c < count; c++) {\n        encode_strided(d + c, e + c, count);\n    }\n}\n";
+
+    // every syndrome of a small single correction code straight to its outcome
+    if (method->CorrectionCapability() == 1 && ecc_width <= COMPILED_ENTRY_TABLE_MAX_BITS) {
+        snprintf(line, sizeof(line), "\nconst uint32_t ecc_entries[%u] = {", 1u << ecc_width);
+        source += line;
+        uint32_t correction;
+        uint32_t correction_count = 0;
+        for (uint32_t s = 0; s < (1u << ecc_width); s++) {
+            ecc_syndrome syndrome;
+            syndrome.w[0] = s;
+            uint32_t entry = ECCDecodeTable::ENTRY_UNCORRECTABLE;
+            ECC_DETECTION detection = method->DecodeSyndrome(syndrome, &correction, correction_count);
+            if (detection == ECC_DETECTION_OK) {
+                entry = ECCDecodeTable::ENTRY_OK;
+            } else if (detection == ECC_DETECTION_CORRECTED) {
+                entry = correction;
+            }
+            snprintf(line, sizeof(line), "%s%uu,", s % 16 == 0 ? "\n    " : " ", entry);
+            source += line;
+        }
+        source += "\n};\n";
+    }
+    return source;
+}
+
+void* ECCMethod_Compiled::LoadLibrary(const std::string& source)
+{
+    // one build per matrix and isa level, failed builds are remembered as well
+    static std::map<std::pair<std::string, ISA>, void*> libraries;
+    const std::pair<std::string, ISA> key(source, isa_active());
+    std::map<std::pair<std::string, ISA>, void*>::iterator it = libraries.find(key);
+    if (it != libraries.end()) {
+        return it->second;
+    }
+    void* library = NULL;
+    const char* tmp_dir = getenv("TMPDIR") != NULL ? getenv("TMPDIR") : "/tmp";
+    std::string dir = std::string(tmp_dir) + "/ecc_memory_XXXXXX";
+    if (mkdtemp(&dir[0]) != NULL) {
+        std::string source_path = dir + "/kernel.c";
+        std::string library_path = dir + "/kernel.so";
+        FILE* f = fopen(source_path.c_str(), "w");
+        if (f != NULL) {
+            bool written = fwrite(source.data(), 1, source.size(), f) == source.size();
+            written = fclose(f) == 0 && written;
+            // built for the active isa level so that --isa pins the compiled kernel too, tuned for the host it never leaves, $CC
+            // may carry its own arguments
+            const char* compiler = getenv("CC") != NULL ? getenv("CC") : "cc";
+            std::string command = std::string(compiler) + " -O2 -march=x86-64 -mtune=native " + COMPILED_ISA_FLAGS[key.second] +
+                                  " -fPIC -shared -o " + shell_quote(library_path) + " " + shell_quote(source_path) + " > /dev/null 2>&1";
+            if (written && system(command.c_str()) == 0) {
+                library = dlopen(library_path.c_str(), RTLD_NOW | RTLD_LOCAL);
+            }
+        }
+        // the loaded mapping outlives the files
+        unlink(library_path.c_str());
+        unlink(source_path.c_str());
+        rmdir(dir.c_str());
+    }
+    libraries[key] = library;
+    return library;
+}
+
+ECC_DETECTION ECCMethod_Compiled::DecodeAndFlip(const ecc_syndrome& syndrome, uint64_t* data, uint64_t* ecc, uint32_t stride, uint32_t* corrections, uint32_t& correction_count)
+{
+    ECC_DETECTION ret;
+    correction_count = 0;
+    if (entries != NULL) {
+        uint32_t entry = entries[syndrome.w[0]];
+        if (entry == ECCDecodeTable::ENTRY_OK) {
+            return ECC_DETECTION_OK;
+        } else if (entry == ECCDecodeTable::ENTRY_UNCORRECTABLE) {
+            return ECC_DETECTION_UNCORRECTABLE;
+        }
+        corrections[correction_count++] = entry;
+        ret = ECC_DETECTION_CORRECTED;
+    } else if (decode_table != NULL) {
+        ret = decode_table->Decode(syndrome.w[0], corrections, correction_count);
+    } else {
+        ret = base->DecodeSyndrome(syndrome, corrections, correction_count);
+    }
+    if (ret != ECC_DETECTION_CORRECTED) {
+        return ret;
+    }
+    uint32_t data_width = base->DataWidth();
+    for (uint32_t ci = 0; ci < correction_count; ci++) {
+        uint32_t pos = corrections[ci];
+        if (pos < data_width) {
+            data[(pos / 64) * stride] ^= (uint64_t)1 << (pos % 64);
+        } else {
+            ecc[((pos - data_width) / 64) * stride] ^= (uint64_t)1 << ((pos - data_width) % 64);
+        }
+    }
+    return ret;
+}
+
+uint32_t ECCMethod_Compiled::DataWidth()
+{
+    return base->DataWidth();
+}
+
+uint32_t ECCMethod_Compiled::ECCWidth()
+{
+    return base->ECCWidth();
+}
+
+void ECCMethod_Compiled::ConstructECCPacked(const uint64_t* data, uint64_t* ecc)
+{
+    if (!compiled_encoder) {
+        base->ConstructECCPacked(data, ecc);
+        return;
+    }
+    encode(data, ecc);
+}
+
+ECC_DETECTION ECCMethod_Compiled::CheckAndCorrectPacked(uint64_t* data, uint64_t* ecc, uint32_t* corrections, uint32_t& correction_count)
+{
+    if (!compiled_encoder) {
+        return base->CheckAndCorrectPacked(data, ecc, corrections, correction_count);
+    }
+    ecc_syndrome syndrome;
+    encode(data, syndrome.w);
+    for (uint32_t wi = 0; wi < ecc_packed_words(base->ECCWidth()); wi++) {
+        syndrome.w[wi] ^= ecc[wi];
+    }
+    return DecodeAndFlip(syndrome, data, ecc, 1, corrections, correction_count);
+}
+
+void ECCMethod_Compiled::ConstructECCBatch(const uint64_t* data, uint64_t* ecc, uint32_t count)
+{
+    if (!compiled_encoder) {
+        base->ConstructECCBatch(data, ecc, count);
+        return;
+    }
+    encode_batch(data, ecc, count);
+}
+
+void ECCMethod_Compiled::CheckAndCorrectBatch(uint64_t* data, uint64_t* ecc, uint32_t count, ECC_DETECTION* detections, uint32_t* corrections, uint32_t* correction_counts)
+{
+    if (!compiled_encoder) {
+        base->CheckAndCorrectBatch(data, ecc, count, detections, corrections, correction_counts);
+        return;
+    }
+    uint32_t ecc_words = ecc_packed_words(base->ECCWidth());
+    uint32_t capability = base->CorrectionCapability();
+    batch_syndromes.resize(ecc_words * count);
+    encode_batch(data, batch_syndromes.data(), count);
+    for (uint32_t c = 0; c < count; c++) {
+        ecc_syndrome syndrome;
+        for (uint32_t wi = 0; wi < ecc_words; wi++) {
+            syndrome.w[wi] = batch_syndromes[wi * count + c] ^ ecc[wi * count + c];
+        }
+        detections[c] = DecodeAndFlip(syndrome, data + c, ecc + c, count, &corrections[c * capability], correction_counts[c]);
+    }
+}
+
+uint32_t ECCMethod_Compiled::CorrectionCapability()
+{
+    return base->CorrectionCapability();
+}
+
+bool ECCMethod_Compiled::BoundedDistance()
+{
+    return base->BoundedDistance();
+}
+
+uint32_t ECCMethod_Compiled::PaddingWidth()
+{
+    return base->PaddingWidth();
+}
+
+ecc_syndrome ECCMethod_Compiled::ColumnSyndrome(uint32_t position)
+{
+    return base->ColumnSyndrome(position);
+}
+
+ECC_DETECTION ECCMethod_Compiled::DecodeSyndrome(const ecc_syndrome& syndrome, uint32_t* corrections, uint32_t& correction_count)
+{
+    return base->DecodeSyndrome(syndrome, corrections, correction_count);
+}
+
+uint32_t ECCMethod_Compiled::PowerSyndromeWidth()
+{
+    return base->PowerSyndromeWidth();
+}
+
+ecc_syndrome ECCMethod_Compiled::PowerColumn(uint32_t position)
+{
+    return base->PowerColumn(position);
+}
+
+ECC_DETECTION ECCMethod_Compiled::DecodePowerSyndrome(const ecc_syndrome& syndrome, uint32_t* corrections, uint32_t& correction_count)
+{
+    return base->DecodePowerSyndrome(syndrome, corrections, correction_count);
+}
+
+uint32_t ECCMethod_Compiled::EncoderVariantCount()
+{
+    return 1 + base->EncoderVariantCount();
+}
+
+const char* ECCMethod_Compiled::EncoderVariantName(uint32_t variant)
+{
+    return variant == 0 ? "compiled" : base->EncoderVariantName(variant - 1);
+}
+
+void ECCMethod_Compiled::SetEncoderVariant(uint32_t variant)
+{
+    assert(variant < EncoderVariantCount());
+    compiled_encoder = variant == 0;
+    if (variant > 0) {
+        base->SetEncoderVariant(variant - 1);
+    }
+}
+
+uint32_t ECCMethod_Compiled::DecoderVariantCount()
+{
+    return base->DecoderVariantCount();
+}
+
+const char* ECCMethod_Compiled::DecoderVariantName(uint32_t variant)
+{
+    return base->DecoderVariantName(variant);
+}
+
+void ECCMethod_Compiled::SetDecoderVariant(uint32_t variant)
+{
+    base->SetDecoderVariant(variant);
+}
+
+void ECCMethod_Compiled::SetDecodeTable(const ECCDecodeTable* table)
+{
+    decode_table = table;
+    base->SetDecodeTable(table);
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ecc.hpp"
+
+// single correction codes up to this many ecc bits also get their syndrome to outcome table compiled in
+static const uint32_t COMPILED_ENTRY_TABLE_MAX_BITS = 16;
+
+class ECCMethod_Compiled : public ECCMethod {
+    // wraps a linear method with a kernel generated for its exact parity matrix, every ecc bit is an unrolled xor tree over the
+    // data words masked with constants, built by the system compiler for the host and loaded with dlopen
+    // encoder variant 0 is the compiled kernel, the others are those of the wrapped method
+
+  private:
+
+    ECCMethod* base; // owned
+
+    typedef void (*encode_function)(const uint64_t* data, uint64_t* ecc);
+    typedef void (*encode_batch_function)(const uint64_t* data, uint64_t* ecc, uint32_t count);
+
+    encode_function encode;
+    encode_batch_function encode_batch;
+    const uint32_t* entries; // ECCDecodeTable entry encoding, NULL if not compiled in
+    bool compiled_encoder;
+    std::vector<uint64_t> batch_syndromes; // scratch of CheckAndCorrectBatch
+
+    ECCMethod_Compiled(ECCMethod* base, void* library);
+
+    static std::string GenerateSource(ECCMethod* method);
+    static void* LoadLibrary(const std::string& source);
+
+    ECC_DETECTION DecodeAndFlip(const ecc_syndrome& syndrome, uint64_t* data, uint64_t* ecc, uint32_t stride, uint32_t* corrections, uint32_t& correction_count);
+
+  public:
+
+    ~ECCMethod_Compiled();
+
+    // linear codes whose decoder needs no padding
+    static bool Fits(ECCMethod* method);
+    // takes ownership of base on success, NULL if no compiler is available or the kernel failed to build
+    static ECCMethod_Compiled* Create(ECCMethod* base);
+
+    uint32_t DataWidth() override;
+    uint32_t ECCWidth() override;
+    void ConstructECCPacked(const uint64_t* data, uint64_t* ecc) override;
+    ECC_DETECTION CheckAndCorrectPacked(uint64_t* data, uint64_t* ecc, uint32_t* corrections, uint32_t& correction_count) override;
+    void ConstructECCBatch(const uint64_t* data, uint64_t* ecc, uint32_t count) override;
+    void CheckAndCorrectBatch(uint64_t* data, uint64_t* ecc, uint32_t count, ECC_DETECTION* detections, uint32_t* corrections, uint32_t* correction_counts) override;
+    uint32_t CorrectionCapability() override;
+    bool BoundedDistance() override;
+    uint32_t PaddingWidth() override;
+    ecc_syndrome ColumnSyndrome(uint32_t position) override;
+    ECC_DETECTION DecodeSyndrome(const ecc_syndrome& syndrome, uint32_t* corrections, uint32_t& correction_count) override;
+    uint32_t PowerSyndromeWidth() override;
+    ecc_syndrome PowerColumn(uint32_t position) override;
+    ECC_DETECTION DecodePowerSyndrome(const ecc_syndrome& syndrome, uint32_t* corrections, uint32_t& correction_count) override;
+    uint32_t EncoderVariantCount() override;
+    const char* EncoderVariantName(uint32_t variant) override;
+    void SetEncoderVariant(uint32_t variant) override;
+    uint32_t DecoderVariantCount() override;
+    const char* DecoderVariantName(uint32_t variant) override;
+    void SetDecoderVariant(uint32_t variant) override;
+    void SetDecodeTable(const ECCDecodeTable* table) override;
+};
@@ -0,0 +1,90 @@
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "ecc.hpp"
+
+#include "decode_table.hpp"
+
+ECCDecodeTable::ECCDecodeTable(const std::vector<ECCMethod*>& methods)
+{
+    assert(methods.size() > 0);
+    assert(Fits(methods[0]));
+    syndrome_bits = methods[0]->ECCWidth();
+    entries.resize(Size());
+
+    // every thread decodes a contiguous syndrome range, multi bit correction sets are merged afterwards
+    uint64_t chunk_count = methods.size();
+    uint64_t chunk_size = (Size() + chunk_count - 1) / chunk_count;
+    std::vector<std::vector<uint32_t>> chunk_sets(chunk_count);
+    std::vector<std::thread> workers;
+    for (uint64_t ci = 0; ci < chunk_count; ci++) {
+        workers.emplace_back([this, &methods, &chunk_sets, ci, chunk_size]() {
+            ECCMethod* method = methods[ci];
+            std::vector<uint32_t> corrections(method->CorrectionCapability());
+            uint64_t end = std::min((ci + 1) * chunk_size, Size());
+            for (uint64_t s = ci * chunk_size; s < end; s++) {
+                ecc_syndrome syndrome;
+                syndrome.w[0] = s;
+                uint32_t correction_count = 0;
+                ECC_DETECTION detection = method->DecodeSyndrome(syndrome, corrections.data(), correction_count);
+                if (detection == ECC_DETECTION_OK) {
+                    entries[s] = ENTRY_OK;
+                } else if (detection == ECC_DETECTION_UNCORRECTABLE) {
+                    entries[s] = ENTRY_UNCORRECTABLE;
+                } else if (correction_count == 1) {
+                    entries[s] = corrections[0];
+                } else {
+                    // chunk local offset for now
+                    entries[s] = ENTRY_SET_FLAG | chunk_sets[ci].size();
+                    chunk_sets[ci].push_back(correction_count);
+                    chunk_sets[ci].insert(chunk_sets[ci].end(), corrections.begin(), corrections.begin() + correction_count);
+                }
+            }
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    // rebase the chunk local set offsets into the merged set storage
+    for (uint64_t ci = 0; ci < chunk_count; ci++) {
+        uint32_t base = correction_sets.size();
+        correction_sets.insert(correction_sets.end(), chunk_sets[ci].begin(), chunk_sets[ci].end());
+        uint64_t end = std::min((ci + 1) * chunk_size, Size());
+        for (uint64_t s = ci * chunk_size; s < end && base > 0; s++) {
+            if (entries[s] != ENTRY_OK && entries[s] != ENTRY_UNCORRECTABLE && (entries[s] & ENTRY_SET_FLAG) != 0) {
+                entries[s] += base;
+            }
+        }
+    }
+    assert(correction_sets.size() < ENTRY_UNCORRECTABLE - ENTRY_SET_FLAG);
+}
+
+ECCDecodeTable::~ECCDecodeTable()
+{
+    // pass
+}
+
+bool ECCDecodeTable::Fits(ECCMethod* method)
+{
+    return method->ECCWidth() <= MAX_SYNDROME_BITS;
+}
+
+uint32_t ECCDecodeTable::SyndromeBits() const
+{
+    return syndrome_bits;
+}
+
+uint64_t ECCDecodeTable::Size() const
+{
+    return (uint64_t)1 << syndrome_bits;
+}
+
+const uint32_t* ECCDecodeTable::CorrectionSet(uint32_t entry) const
+{
+    assert(entry != ENTRY_OK && entry != ENTRY_UNCORRECTABLE && (entry & ENTRY_SET_FLAG) != 0);
+    return &correction_sets[entry & ~ENTRY_SET_FLAG];
+}
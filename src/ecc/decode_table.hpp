@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "ecc.hpp"
+
+class ECCDecodeTable {
+    // dense syndrome to decoder outcome map, built once and then shared read-only between all threads
+
+  public:
+
+    static const uint32_t MAX_SYNDROME_BITS = 24;
+
+    // entry encoding, anything else below ENTRY_SET_FLAG is the single position to correct
+    static const uint32_t ENTRY_OK = UINT32_MAX;
+    static const uint32_t ENTRY_UNCORRECTABLE = UINT32_MAX - 1;
+    static const uint32_t ENTRY_SET_FLAG = 0x80000000; // remaining bits index correction_sets
+
+  private:
+
+    uint32_t syndrome_bits;
+    std::vector<uint32_t> entries;
+    std::vector<uint32_t> correction_sets; // correction count followed by the positions
+
+  public:
+
+    // methods must be equivalent instances, one is used per construction thread
+    ECCDecodeTable(const std::vector<ECCMethod*>& methods);
+    ~ECCDecodeTable();
+
+    static bool Fits(ECCMethod* method);
+
+    uint32_t SyndromeBits() const;
+    uint64_t Size() const;
+
+    uint32_t Entry(uint64_t syndrome) const
+    {
+        return entries[syndrome];
+    }
+
+    ECC_DETECTION Decode(uint64_t syndrome, uint32_t* corrections, uint32_t& correction_count) const
+    {
+        uint32_t entry = entries[syndrome];
+        correction_count = 0;
+        if (entry == ENTRY_OK) {
+            return ECC_DETECTION_OK;
+        } else if (entry == ENTRY_UNCORRECTABLE) {
+            return ECC_DETECTION_UNCORRECTABLE;
+        } else if ((entry & ENTRY_SET_FLAG) == 0) {
+            corrections[correction_count++] = entry;
+            return ECC_DETECTION_CORRECTED;
+        }
+        const uint32_t* set = &correction_sets[entry & ~ENTRY_SET_FLAG];
+        for (; correction_count < set[0]; correction_count++) {
+            corrections[correction_count] = set[1 + correction_count];
+        }
+        return ECC_DETECTION_CORRECTED;
+    }
+
+    // correction set of a ENTRY_SET_FLAG entry, count followed by the positions
+    const uint32_t* CorrectionSet(uint32_t entry) const;
+};
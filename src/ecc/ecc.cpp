@@ -0,0 +1,187 @@
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "ecc.hpp"
+
+static void pack_bits(const std::vector<bool>& bits, uint64_t* packed)
+{
+    for (uint32_t i = 0; i < ecc_packed_words(bits.size()); i++) {
+        packed[i] = 0;
+    }
+    for (uint32_t i = 0; i < bits.size(); i++) {
+        packed[i / 64] |= (uint64_t)bits[i] << (i % 64);
+    }
+}
+
+static void unpack_bits(const uint64_t* packed, std::vector<bool>& bits)
+{
+    for (uint32_t i = 0; i < bits.size(); i++) {
+        bits[i] = (packed[i / 64] >> (i % 64)) & 0b1;
+    }
+}
+
+void ECCMethod::ConstructECCBatch(const uint64_t* data, uint64_t* ecc, uint32_t count)
+{
+    uint32_t data_words = ecc_packed_words(DataWidth());
+    uint32_t ecc_words = ecc_packed_words(ECCWidth());
+    uint64_t data_word[data_words];
+    uint64_t ecc_word[ecc_words];
+    for (uint32_t c = 0; c < count; c++) {
+        for (uint32_t w = 0; w < data_words; w++) {
+            data_word[w] = data[w * count + c];
+        }
+        ConstructECCPacked(data_word, ecc_word);
+        for (uint32_t w = 0; w < ecc_words; w++) {
+            ecc[w * count + c] = ecc_word[w];
+        }
+    }
+}
+
+void ECCMethod::CheckAndCorrectBatch(uint64_t* data, uint64_t* ecc, uint32_t count, ECC_DETECTION* detections, uint32_t* corrections, uint32_t* correction_counts)
+{
+    uint32_t data_words = ecc_packed_words(DataWidth());
+    uint32_t ecc_words = ecc_packed_words(ECCWidth());
+    uint32_t capability = CorrectionCapability();
+    uint64_t data_word[data_words];
+    uint64_t ecc_word[ecc_words];
+    for (uint32_t c = 0; c < count; c++) {
+        for (uint32_t w = 0; w < data_words; w++) {
+            data_word[w] = data[w * count + c];
+        }
+        for (uint32_t w = 0; w < ecc_words; w++) {
+            ecc_word[w] = ecc[w * count + c];
+        }
+        detections[c] = CheckAndCorrectPacked(data_word, ecc_word, &corrections[c * capability], correction_counts[c]);
+        for (uint32_t w = 0; w < data_words; w++) {
+            data[w * count + c] = data_word[w];
+        }
+        for (uint32_t w = 0; w < ecc_words; w++) {
+            ecc[w * count + c] = ecc_word[w];
+        }
+    }
+}
+
+void ECCMethod::ConstructECC(const std::vector<bool>& data, std::vector<bool>& ecc)
+{
+    std::vector<uint64_t> data_packed(ecc_packed_words(DataWidth()));
+    std::vector<uint64_t> ecc_packed(ecc_packed_words(ECCWidth()));
+    pack_bits(data, data_packed.data());
+    ConstructECCPacked(data_packed.data(), ecc_packed.data());
+    ecc.resize(ECCWidth());
+    unpack_bits(ecc_packed.data(), ecc);
+}
+
+ECC_DETECTION ECCMethod::CheckAndCorrect(std::vector<bool>& data, std::vector<bool>& ecc)
+{
+    std::vector<uint32_t> corrections(CorrectionCapability());
+    uint32_t correction_count = 0;
+    return CheckAndCorrectPositions(data, ecc, corrections.data(), correction_count);
+}
+
+ECC_DETECTION ECCMethod::CheckAndCorrectPositions(std::vector<bool>& data, std::vector<bool>& ecc, uint32_t* corrections, uint32_t& correction_count)
+{
+    std::vector<uint64_t> data_packed(ecc_packed_words(DataWidth()));
+    std::vector<uint64_t> ecc_packed(ecc_packed_words(ECCWidth()));
+    pack_bits(data, data_packed.data());
+    pack_bits(ecc, ecc_packed.data());
+    ECC_DETECTION ret = CheckAndCorrectPacked(data_packed.data(), ecc_packed.data(), corrections, correction_count);
+    unpack_bits(data_packed.data(), data);
+    unpack_bits(ecc_packed.data(), ecc);
+    return ret;
+}
+
+uint32_t ECCMethod::CorrectionCapability()
+{
+    return 1;
+}
+
+bool ECCMethod::BoundedDistance()
+{
+    return false;
+}
+
+uint32_t ECCMethod::PaddingWidth()
+{
+    return 0;
+}
+
+ecc_syndrome ECCMethod::ColumnSyndrome(uint32_t position)
+{
+    assert(ECCWidth() <= ECC_SYNDROME_MAX_BITS);
+    std::vector<uint64_t> data(ecc_packed_words(DataWidth()), 0);
+    ecc_syndrome ret;
+    if (position < DataWidth()) {
+        // the ecc of a single data bit is its column, the stored ecc stays zero
+        data[position / 64] = (uint64_t)1 << (position % 64);
+        ConstructECCPacked(data.data(), ret.w);
+    } else {
+        ret.flip(position - DataWidth());
+    }
+    return ret;
+}
+
+ECC_DETECTION ECCMethod::DecodeSyndrome(const ecc_syndrome& syndrome, uint32_t* corrections, uint32_t& correction_count)
+{
+    // the all zero data word has all zero ecc, so storing the syndrome as ecc reproduces it
+    assert(ECCWidth() <= ECC_SYNDROME_MAX_BITS);
+    std::vector<uint64_t> data(ecc_packed_words(DataWidth()), 0);
+    ecc_syndrome ecc = syndrome;
+    return CheckAndCorrectPacked(data.data(), ecc.w, corrections, correction_count);
+}
+
+uint32_t ECCMethod::PowerSyndromeWidth()
+{
+    return 0;
+}
+
+ecc_syndrome ECCMethod::PowerColumn(uint32_t position)
+{
+    printf("method has no power syndrome\n");
+    assert(0);
+    exit(-1);
+}
+
+ECC_DETECTION ECCMethod::DecodePowerSyndrome(const ecc_syndrome& syndrome, uint32_t* corrections, uint32_t& correction_count)
+{
+    printf("method has no power syndrome\n");
+    assert(0);
+    exit(-1);
+}
+
+uint32_t ECCMethod::EncoderVariantCount()
+{
+    return 1;
+}
+
+const char* ECCMethod::EncoderVariantName(uint32_t variant)
+{
+    return "default";
+}
+
+void ECCMethod::SetEncoderVariant(uint32_t variant)
+{
+    assert(variant < EncoderVariantCount());
+}
+
+uint32_t ECCMethod::DecoderVariantCount()
+{
+    return 1;
+}
+
+const char* ECCMethod::DecoderVariantName(uint32_t variant)
+{
+    return "default";
+}
+
+void ECCMethod::SetDecoderVariant(uint32_t variant)
+{
+    assert(variant < DecoderVariantCount());
+}
+
+void ECCMethod::SetDecodeTable(const ECCDecodeTable* table)
+{
+    decode_table = table;
+}
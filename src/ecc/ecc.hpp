@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <vector>
 
@@ -9,8 +10,79 @@ enum ECC_DETECTION {
     ECC_DETECTION_UNCORRECTABLE,
 };
 
+struct ecc_stats {
+    uint64_t detection_ok = 0;
+    uint64_t detection_corrected = 0;
+    uint64_t detection_uncorrectable = 0;
+    uint64_t false_corrections = 0;
+};
+
+static const uint32_t ECC_SYNDROME_MAX_BITS = 256;
+
+// packed buffers hold bit i in word i / 64 at bit i % 64, bits past the width are zero
+static inline uint32_t ecc_packed_words(uint32_t bits)
+{
+    return (bits + 63) / 64;
+}
+
+struct ecc_syndrome {
+    // bit i is ecc[i] xor the ecc recomputed from the data, this is linear in the error pattern and independent of the stored data
+    uint64_t w[ECC_SYNDROME_MAX_BITS / 64] = {};
+
+    bool get(uint32_t bit) const
+    {
+        return (w[bit / 64] >> (bit % 64)) & 0b1;
+    }
+
+    void flip(uint32_t bit)
+    {
+        w[bit / 64] ^= (uint64_t)1 << (bit % 64);
+    }
+
+    bool zero() const
+    {
+        uint64_t acc = 0;
+        for (uint32_t i = 0; i < ECC_SYNDROME_MAX_BITS / 64; i++) {
+            acc |= w[i];
+        }
+        return acc == 0;
+    }
+
+    uint32_t weight() const
+    {
+        uint32_t ret = 0;
+        for (uint32_t i = 0; i < ECC_SYNDROME_MAX_BITS / 64; i++) {
+            ret += __builtin_popcountll(w[i]);
+        }
+        return ret;
+    }
+
+    ecc_syndrome& operator^=(const ecc_syndrome& other)
+    {
+        for (uint32_t i = 0; i < ECC_SYNDROME_MAX_BITS / 64; i++) {
+            w[i] ^= other.w[i];
+        }
+        return *this;
+    }
+
+    bool operator==(const ecc_syndrome& other) const
+    {
+        uint64_t acc = 0;
+        for (uint32_t i = 0; i < ECC_SYNDROME_MAX_BITS / 64; i++) {
+            acc |= w[i] ^ other.w[i];
+        }
+        return acc == 0;
+    }
+};
+
+class ECCDecodeTable;
+
 class ECCMethod {
 
+  protected:
+
+    const ECCDecodeTable* decode_table = NULL; // shared, not owned
+
   public:
 
     ECCMethod(){};
@@ -18,6 +90,53 @@ class ECCMethod {
 
     virtual uint32_t DataWidth() = 0;
     virtual uint32_t ECCWidth() = 0;
-    virtual void ConstructECC(std::vector<bool>& data, std::vector<bool>& ecc) = 0;
-    virtual ECC_DETECTION CheckAndCorrect(std::vector<bool>& data, std::vector<bool>& ecc) = 0;
+    // packed word api, ecc is fully overwritten
+    virtual void ConstructECCPacked(const uint64_t* data, uint64_t* ecc) = 0;
+    // also reports the flipped positions (indexed like DecodeSyndrome below) the way decode_bch fills errloc, at most CorrectionCapability()
+    // of them, correction_count is only valid for ECC_DETECTION_CORRECTED
+    virtual ECC_DETECTION CheckAndCorrectPacked(uint64_t* data, uint64_t* ecc, uint32_t* corrections, uint32_t& correction_count) = 0;
+
+    // batched packed api over count codewords stored as structure of arrays, word w of codeword c is at [w * count + c]
+    // corrections of codeword c start at [c * CorrectionCapability()], the defaults loop over the single word calls
+    virtual void ConstructECCBatch(const uint64_t* data, uint64_t* ecc, uint32_t count);
+    virtual void CheckAndCorrectBatch(uint64_t* data, uint64_t* ecc, uint32_t count, ECC_DETECTION* detections, uint32_t* corrections, uint32_t* correction_counts);
+
+    // std::vector<bool> adapters over the packed api
+    void ConstructECC(const std::vector<bool>& data, std::vector<bool>& ecc);
+    ECC_DETECTION CheckAndCorrect(std::vector<bool>& data, std::vector<bool>& ecc);
+    ECC_DETECTION CheckAndCorrectPositions(std::vector<bool>& data, std::vector<bool>& ecc, uint32_t* corrections, uint32_t& correction_count);
+
+    // syndrome domain, positions index the word as data bits followed by ecc bits
+    // the defaults materialize a word and go through the packed api, implementations should override them with direct versions
+    virtual uint32_t CorrectionCapability();
+    // true if the decoder corrects exactly the error patterns of weight <= CorrectionCapability() and flags everything else uncorrectable,
+    // its outcomes are then determined by the weight distribution of the code alone
+    virtual bool BoundedDistance();
+    // bits the decoder works on beyond the word, always zero in storage but possible error locations, ColumnSyndrome places them after
+    // the ecc bits
+    virtual uint32_t PaddingWidth();
+    virtual ecc_syndrome ColumnSyndrome(uint32_t position);
+    // writes at most CorrectionCapability() positions to corrections, correction_count is only valid for ECC_DETECTION_CORRECTED
+    virtual ECC_DETECTION DecodeSyndrome(const ecc_syndrome& syndrome, uint32_t* corrections, uint32_t& correction_count);
+
+    // second linear syndrome that the decoder consumes without deriving it from the ecc syndrome first, for bch the odd power sums of
+    // the error locations, 0 bits if the method has none, positions as in ColumnSyndrome
+    virtual uint32_t PowerSyndromeWidth();
+    virtual ecc_syndrome PowerColumn(uint32_t position);
+    virtual ECC_DETECTION DecodePowerSyndrome(const ecc_syndrome& syndrome, uint32_t* corrections, uint32_t& correction_count);
+
+    // interchangeable encoder implementations with identical results, the fastest one depends on the code size and the host so main
+    // benchmarks them, variant 0 is the one a new instance uses
+    virtual uint32_t EncoderVariantCount();
+    virtual const char* EncoderVariantName(uint32_t variant);
+    virtual void SetEncoderVariant(uint32_t variant);
+
+    // interchangeable decoder implementations with identical results, benchmarked by main like the encoders, variant 0 is the one a
+    // new instance uses
+    virtual uint32_t DecoderVariantCount();
+    virtual const char* DecoderVariantName(uint32_t variant);
+    virtual void SetDecoderVariant(uint32_t variant);
+
+    // lets CheckAndCorrect classify through a table built for an equivalent method, DecodeSyndrome always decodes directly so it can build tables
+    virtual void SetDecodeTable(const ECCDecodeTable* table);
 };
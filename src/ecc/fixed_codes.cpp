@@ -0,0 +1,30 @@
+#include <cstddef>
+#include <cstdint>
+
+#include "util/isa.hpp"
+
+#include "fixed_codes.hpp"
+
+template <typename CODE>
+static fixed_code fixed_code_entry()
+{
+    return {CODE::FAMILY, CODE::DATA_WIDTH, CODE::ECC_WIDTH, fixed_code_columns<CODE>::columns, fixed_code_positions<CODE>::positions, fixed_encode<CODE>, fixed_encode_popcnt<CODE>};
+}
+
+static const fixed_code FIXED_CODES[] = {
+    fixed_code_entry<fixed_hamming_code>(),
+    fixed_code_entry<fixed_hsiao_code<32, 7>>(),
+    fixed_code_entry<fixed_hsiao_code<64, 8>>(),
+    fixed_code_entry<fixed_hsiao_code<128, 9>>(),
+    fixed_code_entry<fixed_hsiao_code<256, 10>>(),
+};
+
+const fixed_code* fixed_code_find(FIXED_CODE_FAMILY family, uint32_t data_width, uint32_t ecc_width)
+{
+    for (const fixed_code& code : FIXED_CODES) {
+        if (code.family == family && code.data_width == data_width && code.ecc_width == ecc_width) {
+            return &code;
+        }
+    }
+    return NULL;
+}
@@ -0,0 +1,261 @@
+#pragma once
+
+#include <cstdint>
+
+#include "util/isa.hpp"
+
+// parity matrices of the standard configurations, evaluated by the compiler so the kernels over them unroll into constant masks
+// the constexpr functions follow the runtime constructions entry by entry, c++11 constexpr allows a single return statement only
+
+enum FIXED_CODE_FAMILY {
+    FIXED_CODE_HAMMING = 0,
+    FIXED_CODE_HSIAO,
+};
+
+static const uint32_t FIXED_CODE_NO_POSITION = UINT32_MAX;
+
+struct fixed_code {
+    FIXED_CODE_FAMILY family;
+    uint32_t data_width;
+    uint32_t ecc_width;
+    const uint64_t* columns; // syndrome of every position, data bits followed by ecc bits
+    const uint32_t* positions; // position of every syndrome equal to a column, FIXED_CODE_NO_POSITION otherwise
+    void (*encode)(const uint64_t* data, uint64_t* ecc);
+    void (*encode_popcnt)(const uint64_t* data, uint64_t* ecc);
+};
+
+// NULL if the configuration has no fixed code
+const fixed_code* fixed_code_find(FIXED_CODE_FAMILY family, uint32_t data_width, uint32_t ecc_width);
+
+constexpr uint32_t fixed_ncr(uint32_t n, uint32_t r)
+{
+    return r > n ? 0 : r == 0 ? 1 : fixed_ncr(n, r - 1) * (n - r + 1) / r;
+}
+
+constexpr uint32_t fixed_popcount(uint64_t v)
+{
+    return v == 0 ? 0 : (uint32_t)(v & 0b1) + fixed_popcount(v >> 1);
+}
+
+// hamming 64/8, position numbers skip the powers of two, see ECCMethod_Hamming
+
+constexpr uint32_t fixed_hamming_bit_num(uint32_t data_idx, uint32_t bit_num = 3, uint32_t seen = 0)
+{
+    return (bit_num & (bit_num - 1)) == 0 ? fixed_hamming_bit_num(data_idx, bit_num + 1, seen) : seen == data_idx ? bit_num : fixed_hamming_bit_num(data_idx, bit_num + 1, seen + 1);
+}
+
+constexpr uint64_t fixed_hamming_column(uint32_t position)
+{
+    return position >= 64 ? (uint64_t)1 << (position - 64) : fixed_hamming_bit_num(position) | (uint64_t)(~fixed_popcount(fixed_hamming_bit_num(position)) & 0b1) << 7;
+}
+
+// hsiao, entry (r, c) of the delta sub-matrix of ECCMethod_Hsiao::matrix_construction_delta
+
+constexpr uint32_t fixed_hsiao_m1(uint32_t rows, uint32_t cols, uint32_t weight)
+{
+    return (cols * weight + rows - 1) / rows;
+}
+
+constexpr uint32_t fixed_hsiao_r1(uint32_t rows, uint32_t cols, uint32_t weight)
+{
+    return ((weight - 1) * fixed_hsiao_m1(rows, cols, weight)) % (rows - 1);
+}
+
+constexpr uint32_t fixed_hsiao_r2(uint32_t rows, uint32_t cols, uint32_t weight)
+{
+    return (weight * (cols - fixed_hsiao_m1(rows, cols, weight))) % (rows - 1);
+}
+
+// row order[i] of delta2 that lands in row i of delta2 prime, the shift is a rotation if r1 + r2 wraps and a block swap otherwise
+constexpr uint32_t fixed_hsiao_order_wrap(uint32_t rows, uint32_t shift, uint32_t i)
+{
+    return i < rows - 1 - shift ? shift + i : i - (rows - 1 - shift);
+}
+
+constexpr uint32_t fixed_hsiao_order_swap(uint32_t r1, uint32_t r2, uint32_t head, uint32_t i)
+{
+    return i < head ? r2 + i : i < head + r2 ? i - head : r1 + 1 + i - head;
+}
+
+constexpr uint32_t fixed_hsiao_order(uint32_t rows, uint32_t r1, uint32_t r2, uint32_t i)
+{
+    return r1 + r2 > rows - 1 ? fixed_hsiao_order_wrap(rows, rows - 1 - r1, i) : fixed_hsiao_order_swap(r1, r2, r1 + 1 < rows - 1 - r2 ? r1 + 1 : rows - 1 - r2, i);
+}
+
+constexpr bool fixed_hsiao_delta(uint32_t rows, uint32_t cols, uint32_t weight, uint32_t r, uint32_t c)
+{
+    // the general case is a top row of m1 ones over delta1 of weight - 1 next to the reordered delta2
+    return weight == 0 ? false
+        : weight == rows ? true
+        : cols == 1 ? r < weight
+        : weight == 1 ? r == c
+        : weight == rows - 1 ? r < rows - cols || r - (rows - cols) != c
+        : r == 0 ? c < fixed_hsiao_m1(rows, cols, weight)
+        : c < fixed_hsiao_m1(rows, cols, weight) ? fixed_hsiao_delta(rows - 1, fixed_hsiao_m1(rows, cols, weight), weight - 1, r - 1, c)
+        : fixed_hsiao_delta(rows - 1, cols - fixed_hsiao_m1(rows, cols, weight), weight, fixed_hsiao_order(rows, fixed_hsiao_r1(rows, cols, weight), fixed_hsiao_r2(rows, cols, weight), r - 1),
+                            c - fixed_hsiao_m1(rows, cols, weight));
+}
+
+// weight of the highest weight columns and the number of columns below it, counting the identity
+constexpr uint32_t fixed_hsiao_max_weight(uint32_t n, uint32_t k, uint32_t weight = 1, uint32_t total = 0)
+{
+    return n > total + fixed_ncr(k, weight) ? fixed_hsiao_max_weight(n, k, weight + 2, total + fixed_ncr(k, weight)) : weight;
+}
+
+constexpr uint32_t fixed_hsiao_prev_total(uint32_t n, uint32_t k, uint32_t weight = 1, uint32_t total = 0)
+{
+    return n > total + fixed_ncr(k, weight) ? fixed_hsiao_prev_total(n, k, weight + 2, total + fixed_ncr(k, weight)) : total;
+}
+
+// data column c counted from the sub-matrix of the given weight on, all but the last one are complete
+constexpr bool fixed_hsiao_part(uint32_t n, uint32_t k, uint32_t weight, uint32_t r, uint32_t c)
+{
+    return weight < fixed_hsiao_max_weight(n, k)
+               ? (c < fixed_ncr(k, weight) ? fixed_hsiao_delta(k, fixed_ncr(k, weight), weight, r, c) : fixed_hsiao_part(n, k, weight + 2, r, c - fixed_ncr(k, weight)))
+               : fixed_hsiao_delta(k, n - fixed_hsiao_prev_total(n, k), weight, r, c);
+}
+
+constexpr uint64_t fixed_hsiao_column(uint32_t d, uint32_t k, uint32_t position, uint32_t r = 0)
+{
+    return r == k ? 0 : (uint64_t)(position < d ? fixed_hsiao_part(d + k, k, 3, r, position) : r == position - d) << r | fixed_hsiao_column(d, k, position, r + 1);
+}
+
+// code descriptions, DATA_WIDTH + ECC_WIDTH columns of at most 64 ecc bits
+
+struct fixed_hamming_code {
+    static const FIXED_CODE_FAMILY FAMILY = FIXED_CODE_HAMMING;
+    static const uint32_t DATA_WIDTH = 64;
+    static const uint32_t ECC_WIDTH = 8;
+
+    static constexpr uint64_t Column(uint32_t position)
+    {
+        return fixed_hamming_column(position);
+    }
+};
+
+template <uint32_t D, uint32_t K>
+struct fixed_hsiao_code {
+    static const FIXED_CODE_FAMILY FAMILY = FIXED_CODE_HSIAO;
+    static const uint32_t DATA_WIDTH = D;
+    static const uint32_t ECC_WIDTH = K;
+
+    static constexpr uint64_t Column(uint32_t position)
+    {
+        return fixed_hsiao_column(D, K, position);
+    }
+};
+
+// index lists for the table pack expansions, built by halving so the instantiation depth stays logarithmic
+template <uint32_t... I>
+struct fixed_indices {
+};
+
+template <typename A, typename B>
+struct fixed_concat;
+
+template <uint32_t... I, uint32_t... J>
+struct fixed_concat<fixed_indices<I...>, fixed_indices<J...>> {
+    typedef fixed_indices<I..., (uint32_t)sizeof...(I) + J...> type;
+};
+
+template <uint32_t N>
+struct fixed_make_indices {
+    typedef typename fixed_concat<typename fixed_make_indices<N / 2>::type, typename fixed_make_indices<N - N / 2>::type>::type type;
+};
+
+template <>
+struct fixed_make_indices<0> {
+    typedef fixed_indices<> type;
+};
+
+template <>
+struct fixed_make_indices<1> {
+    typedef fixed_indices<0> type;
+};
+
+// the column table is filled first so the row masks and the syndrome search read it instead of evaluating columns again
+template <typename CODE, typename POSITIONS = typename fixed_make_indices<CODE::DATA_WIDTH + CODE::ECC_WIDTH>::type>
+struct fixed_code_columns;
+
+template <typename CODE, uint32_t... P>
+struct fixed_code_columns<CODE, fixed_indices<P...>> {
+    static constexpr uint64_t columns[] = {CODE::Column(P)...};
+};
+
+template <typename CODE, uint32_t... P>
+constexpr uint64_t fixed_code_columns<CODE, fixed_indices<P...>>::columns[];
+
+// data part of a parity row within one data word
+template <typename CODE>
+constexpr uint64_t fixed_row_mask(uint32_t row, uint32_t word, uint32_t bit = 0)
+{
+    return bit == 64 || word * 64 + bit >= CODE::DATA_WIDTH ? 0 : ((fixed_code_columns<CODE>::columns[word * 64 + bit] >> row) & 0b1) << bit | fixed_row_mask<CODE>(row, word, bit + 1);
+}
+
+template <typename CODE>
+constexpr uint32_t fixed_position(uint64_t syndrome, uint32_t position = 0)
+{
+    return position == CODE::DATA_WIDTH + CODE::ECC_WIDTH ? FIXED_CODE_NO_POSITION
+        : syndrome != 0 && fixed_code_columns<CODE>::columns[position] == syndrome ? position
+        : fixed_position<CODE>(syndrome, position + 1);
+}
+
+template <typename CODE, typename SYNDROMES = typename fixed_make_indices<1u << CODE::ECC_WIDTH>::type>
+struct fixed_code_positions;
+
+template <typename CODE, uint32_t... S>
+struct fixed_code_positions<CODE, fixed_indices<S...>> {
+    static constexpr uint32_t positions[] = {fixed_position<CODE>(S)...};
+};
+
+template <typename CODE, uint32_t... S>
+constexpr uint32_t fixed_code_positions<CODE, fixed_indices<S...>>::positions[];
+
+// unrolled encoder, every row is the parity of the xor of the masked data words
+template <typename CODE, uint32_t ROW, uint32_t WORD>
+struct fixed_row_xor {
+    static constexpr uint64_t MASK = fixed_row_mask<CODE>(ROW, WORD);
+
+    static ISA_INLINE uint64_t Xor(const uint64_t* data)
+    {
+        return (data[WORD] & MASK) ^ fixed_row_xor<CODE, ROW, WORD - 1>::Xor(data);
+    }
+};
+
+template <typename CODE, uint32_t ROW>
+struct fixed_row_xor<CODE, ROW, 0> {
+    static constexpr uint64_t MASK = fixed_row_mask<CODE>(ROW, 0);
+
+    static ISA_INLINE uint64_t Xor(const uint64_t* data)
+    {
+        return data[0] & MASK;
+    }
+};
+
+template <typename CODE, uint32_t ROWS>
+struct fixed_rows {
+    static ISA_INLINE uint64_t Ecc(const uint64_t* data)
+    {
+        return fixed_rows<CODE, ROWS - 1>::Ecc(data) | (uint64_t)__builtin_parityll(fixed_row_xor<CODE, ROWS - 1, (CODE::DATA_WIDTH + 63) / 64 - 1>::Xor(data)) << (ROWS - 1);
+    }
+};
+
+template <typename CODE>
+struct fixed_rows<CODE, 0> {
+    static ISA_INLINE uint64_t Ecc(const uint64_t*)
+    {
+        return 0;
+    }
+};
+
+template <typename CODE>
+void fixed_encode(const uint64_t* data, uint64_t* ecc)
+{
+    ecc[0] = fixed_rows<CODE, CODE::ECC_WIDTH>::Ecc(data);
+}
+
+template <typename CODE>
+ISA_TARGET_POPCNT void fixed_encode_popcnt(const uint64_t* data, uint64_t* ecc)
+{
+    ecc[0] = fixed_rows<CODE, CODE::ECC_WIDTH>::Ecc(data);
+}
@@ -1,7 +1,11 @@
+#include <cassert>
 #include <cstdint>
 #include <vector>
 
 #include "ecc.hpp"
+#include "fixed_codes.hpp"
+#include "syndrome_kernel.hpp"
+#include "util/isa.hpp"
 
 #include "hamming.hpp"
 
@@ -13,8 +17,19 @@ bool single_bit_set(uint8_t v)
     return (v & (v - 1)) == 0;
 }
 
-ECCMethod_Hamming::ECCMethod_Hamming()
+ECCMethod_Hamming::ECCMethod_Hamming():
+    table_encoder(false)
 {
+    // data bit flips the ecc bits of its position, skipping the positions that belong to the ecc part, and the total parity
+    // unless that flip already changes the parity of the ecc part, the columns are evaluated at compile time, see fixed_hamming_column
+    fixed = fixed_code_find(FIXED_CODE_HAMMING, DataWidth(), ECCWidth());
+    assert(fixed != NULL);
+    fixed_encode = isa_active() >= ISA_POPCNT ? fixed->encode_popcnt : fixed->encode;
+    std::vector<ecc_syndrome> columns(DataWidth());
+    for (uint32_t ci = 0; ci < DataWidth(); ci++) {
+        columns[ci].w[0] = fixed->columns[ci];
+    }
+    kernel.Build(DataWidth(), ECCWidth(), columns);
 }
 
 ECCMethod_Hamming::~ECCMethod_Hamming()
@@ -31,88 +46,115 @@ uint32_t ECCMethod_Hamming::ECCWidth()
     return 8;
 }
 
-void ECCMethod_Hamming::ConstructECC(std::vector<bool>& data, std::vector<bool>& ecc)
+void ECCMethod_Hamming::ConstructECCPacked(const uint64_t* data, uint64_t* ecc)
 {
-    uint8_t ecc_byte = 0x00;
-    ecc.assign(ECCWidth(), 0);
-    // construct parity bits such that all covered bits AND the parity bit equal 0 parity
-    uint8_t bit_num = 1;
-    uint8_t ecc_bit_skip = 0;
-    bool total_parity = false;
-    for (; bit_num <= (DataWidth() + ECCWidth() - 1); bit_num++) {
-        // skip if this bit, num actually belongs to the ecc part, but remember the skip cnt
-        if (single_bit_set(bit_num)) {
-            ecc_bit_skip++;
-            continue;
-        }
-        // data bit flips corresponding ecc bits if it is set
-        // flip using the position as mask for the ecc
-        uint8_t bit_idx = bit_num - 1 - ecc_bit_skip;
-        if (data[bit_idx]) {
-            ecc_byte ^= bit_num;
-            total_parity = !total_parity;
-        }
+    // parity bits such that all covered bits AND the parity bit equal 0 parity
+    if (table_encoder) {
+        kernel.Encode(data, ecc);
+        return;
     }
-    // assign ecc into vector
-    for (uint8_t i = 0; i < ECCWidth() - 1; i++) {
-        bool is_set = (ecc_byte >> i) & 0b1;
-        ecc[i] = is_set;
-        if (is_set) {
-            total_parity = !total_parity;
-        }
-    }
-    // save total parity
-    ecc[ECCWidth() - 1] = total_parity;
+    fixed_encode(data, ecc);
 }
 
-ECC_DETECTION ECCMethod_Hamming::CheckAndCorrect(std::vector<bool>& data, std::vector<bool>& ecc)
+ECC_DETECTION ECCMethod_Hamming::CheckAndCorrectPacked(uint64_t* data, uint64_t* ecc, uint32_t* corrections, uint32_t& correction_count)
 {
-    std::vector<bool> check_ecc;
-    ConstructECC(data, check_ecc);
-    uint8_t syndrome = 0x00;
-    for (uint8_t i = 0; i < ECCWidth() - 1; i++) {
-        syndrome |= (ecc[i] != check_ecc[i]) << i;
-        // printf("syndrome %hhu: %c\n", i, ((ecc[i] != check_ecc[i]) << i) ? '1' : '0');
-    }
-    bool total_parity = false;
-    for (uint8_t i = 0; i < DataWidth(); i++) {
-        if (data[i]) {
-            total_parity = !total_parity;
-        }
-    }
-    for (uint8_t i = 0; i < ECCWidth() - 1; i++) {
-        if (ecc[i]) {
-            total_parity = !total_parity;
-        }
-    }
-    if (total_parity == ecc[ECCWidth() - 1]) {
+    correction_count = 0;
+    uint64_t check_ecc;
+    ECCMethod_Hamming::ConstructECCPacked(data, &check_ecc);
+    uint8_t syndrome = (ecc[0] ^ check_ecc) & 0x7F;
+    bool total_parity = (__builtin_popcountll(data[0]) + __builtin_popcountll(ecc[0] & 0x7F)) & 0b1;
+    bool stored_parity = (ecc[0] >> (ECCWidth() - 1)) & 0b1;
+    if (total_parity == stored_parity) {
         // total parity is correct, either everything is fine, or uncorrectable multi-bit error
         if (syndrome == 0) {
             return ECC_DETECTION_OK;
         } else {
             return ECC_DETECTION_UNCORRECTABLE;
         }
-    } else if (total_parity != ecc[ECCWidth() - 1] && syndrome == 0) {
+    } else if (syndrome == 0) {
         // total parity broken, but no syndrome -> single bit error on total parity
-        ecc[ECCWidth() - 1] = total_parity;
+        ecc[0] ^= (uint64_t)1 << (ECCWidth() - 1);
+        corrections[correction_count++] = DataWidth() + ECCWidth() - 1;
         return ECC_DETECTION_CORRECTED;
     }
     // single bit error via syndrome
-    uint8_t ecc_bit_skip = 0;
-    uint8_t syndrome_bits_set = 0;
-    for (uint8_t i = 0; i < ECCWidth() - 1; i++) {
-        if ((syndrome >> i) & 0b1) {
-            ecc_bit_skip = i;
-            syndrome_bits_set++;
-        }
-    }
-    if (syndrome_bits_set == 1) {
+    uint8_t ecc_bit_skip = 31 - __builtin_clz(syndrome);
+    if (single_bit_set(syndrome)) {
         // parity bit correction
-        ecc[ecc_bit_skip] = !ecc[ecc_bit_skip];
+        ecc[0] ^= (uint64_t)1 << ecc_bit_skip;
+        corrections[correction_count++] = DataWidth() + ecc_bit_skip;
     } else {
         // use parity position sum (syndrome)
         ecc_bit_skip++;
-        data[syndrome - 1 - ecc_bit_skip] = !data[syndrome - 1 - ecc_bit_skip];
+        if (syndrome - 1 - ecc_bit_skip >= DataWidth()) {
+            // syndrome points past the last data bit, no single bit error produces this
+            return ECC_DETECTION_UNCORRECTABLE;
+        }
+        data[0] ^= (uint64_t)1 << (syndrome - 1 - ecc_bit_skip);
+        corrections[correction_count++] = syndrome - 1 - ecc_bit_skip;
+    }
+    return ECC_DETECTION_CORRECTED;
+}
+
+void ECCMethod_Hamming::ConstructECCBatch(const uint64_t* data, uint64_t* ecc, uint32_t count)
+{
+    // a single data and ecc word, so the batch rows are plain arrays
+    for (uint32_t c = 0; c < count; c++) {
+        ECCMethod_Hamming::ConstructECCPacked(&data[c], &ecc[c]);
+    }
+}
+
+void ECCMethod_Hamming::CheckAndCorrectBatch(uint64_t* data, uint64_t* ecc, uint32_t count, ECC_DETECTION* detections, uint32_t* corrections, uint32_t* correction_counts)
+{
+    for (uint32_t c = 0; c < count; c++) {
+        detections[c] = ECCMethod_Hamming::CheckAndCorrectPacked(&data[c], &ecc[c], &corrections[c], correction_counts[c]);
+    }
+}
+
+bool ECCMethod_Hamming::BoundedDistance()
+{
+    return true;
+}
+
+ECC_DETECTION ECCMethod_Hamming::DecodeSyndrome(const ecc_syndrome& syndrome, uint32_t* corrections, uint32_t& correction_count)
+{
+    // same decision as CheckAndCorrect, the total parity mismatch is the stored parity difference combined with the parity of the position syndrome
+    uint8_t position_syndrome = syndrome.w[0] & 0x7F;
+    bool total_parity_broken = ((syndrome.w[0] >> 7) ^ __builtin_popcount(position_syndrome)) & 0b1;
+    correction_count = 0;
+    if (!total_parity_broken) {
+        return position_syndrome == 0 ? ECC_DETECTION_OK : ECC_DETECTION_UNCORRECTABLE;
+    }
+    if (position_syndrome == 0) {
+        corrections[correction_count++] = DataWidth() + ECCWidth() - 1;
+        return ECC_DETECTION_CORRECTED;
+    }
+    uint8_t highest_bit = 31 - __builtin_clz(position_syndrome);
+    if (single_bit_set(position_syndrome)) {
+        corrections[correction_count++] = DataWidth() + highest_bit;
+        return ECC_DETECTION_CORRECTED;
+    }
+    uint32_t data_idx = position_syndrome - 2 - highest_bit;
+    if (data_idx >= DataWidth()) {
+        return ECC_DETECTION_UNCORRECTABLE;
     }
+    corrections[correction_count++] = data_idx;
     return ECC_DETECTION_CORRECTED;
 }
+
+uint32_t ECCMethod_Hamming::EncoderVariantCount()
+{
+    // unrolled constant masks, byte table
+    return 2;
+}
+
+const char* ECCMethod_Hamming::EncoderVariantName(uint32_t variant)
+{
+    return variant == 0 ? "fixed" : "table";
+}
+
+void ECCMethod_Hamming::SetEncoderVariant(uint32_t variant)
+{
+    assert(variant < EncoderVariantCount());
+    table_encoder = variant == 1;
+}
@@ -4,12 +4,19 @@
 #include <vector>
 
 #include "ecc.hpp"
+#include "fixed_codes.hpp"
+#include "syndrome_kernel.hpp"
 
 class ECCMethod_Hamming : public ECCMethod {
     // SECDED with hamming, 8 ecc bits per 64 data bits
 
   private:
 
+    const fixed_code* fixed;
+    void (*fixed_encode)(const uint64_t* data, uint64_t* ecc); // isa variant of the fixed encoder
+    ECCSyndromeKernel kernel;
+    bool table_encoder; // encode through the kernel instead of the fixed encoder
+
   public:
 
     ECCMethod_Hamming();
@@ -17,6 +24,13 @@ class ECCMethod_Hamming : public ECCMethod {
 
     uint32_t DataWidth() override;
     uint32_t ECCWidth() override;
-    void ConstructECC(std::vector<bool>& data, std::vector<bool>& ecc) override;
-    ECC_DETECTION CheckAndCorrect(std::vector<bool>& data, std::vector<bool>& ecc) override;
+    void ConstructECCPacked(const uint64_t* data, uint64_t* ecc) override;
+    ECC_DETECTION CheckAndCorrectPacked(uint64_t* data, uint64_t* ecc, uint32_t* corrections, uint32_t& correction_count) override;
+    void ConstructECCBatch(const uint64_t* data, uint64_t* ecc, uint32_t count) override;
+    void CheckAndCorrectBatch(uint64_t* data, uint64_t* ecc, uint32_t count, ECC_DETECTION* detections, uint32_t* corrections, uint32_t* correction_counts) override;
+    bool BoundedDistance() override;
+    ECC_DETECTION DecodeSyndrome(const ecc_syndrome& syndrome, uint32_t* corrections, uint32_t& correction_count) override;
+    uint32_t EncoderVariantCount() override;
+    const char* EncoderVariantName(uint32_t variant) override;
+    void SetEncoderVariant(uint32_t variant) override;
 };
@@ -5,9 +5,14 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <immintrin.h>
 #include <vector>
 
 #include "ecc.hpp"
+#include "decode_table.hpp"
+#include "syndrome_kernel.hpp"
+#include "util/combinations.hpp"
+#include "util/isa.hpp"
 
 #include "hsiao.hpp"
 
@@ -32,17 +37,32 @@ ECCMethod_Hsiao::ECCMethod_Hsiao(int data_bits, int parity_bits, bool debug_prin
         assert(0);
         exit(-1);
     }
+    if (parity_bits > (int)ECC_SYNDROME_MAX_BITS) {
+        printf("too many parity bits (%i), at most %u are supported\n", parity_bits, ECC_SYNDROME_MAX_BITS);
+        assert(0);
+        exit(-1);
+    }
     d = data_bits;
     k = parity_bits;
     n = d + k;
-    matrix hsiao_code = matrix_construction(d, k, debug_print);
-    parity_matrix_by_rows.resize(k, std::vector<bool>(n, false));
-    parity_matrix_by_columns.resize(n, std::vector<bool>(k, false));
+    fixed = fixed_code_find(FIXED_CODE_HSIAO, d, k);
+    if (fixed != NULL) {
+        column_syndromes.resize(n);
+        for (int ci = 0; ci < n; ci++) {
+            column_syndromes[ci].w[0] = fixed->columns[ci];
+        }
+    } else {
+        column_syndromes = ConstructColumns(d, k, debug_print);
+        fixed_encode = NULL;
+    }
+    data_words = ecc_packed_words(d);
+    row_masks.resize(data_words * k, 0);
     for (int ri = 0; ri < k; ri++) {
         for (int ci = 0; ci < n; ci++) {
-            bool bit = hsiao_code.d[ri][ci] != 0;
-            parity_matrix_by_rows[ri][ci] = bit;
-            parity_matrix_by_columns[ci][ri] = bit;
+            bool bit = column_syndromes[ci].get(ri);
+            if (bit && ci < d) {
+                row_masks[(ci / 64) * k + ri] |= (uint64_t)1 << (ci % 64);
+            }
             if (debug_print) {
                 printf("%c", '0' + bit);
             }
@@ -51,6 +71,61 @@ ECCMethod_Hsiao::ECCMethod_Hsiao(int data_bits, int parity_bits, bool debug_prin
             printf("\n");
         }
     }
+    switch (data_words) {
+        case 1:
+            SelectConstructRows<1>();
+            break;
+        case 2:
+            SelectConstructRows<2>();
+            break;
+        case 4:
+            SelectConstructRows<4>();
+            break;
+        case 8:
+            SelectConstructRows<8>();
+            break;
+        default:
+            SelectConstructRows<0>();
+            break;
+    }
+    if (ECCSyndromeKernel::TableBytes(d, k) <= SYNDROME_KERNEL_MAX_TABLE_BYTES) {
+        kernel.Build(d, k, column_syndromes);
+    }
+    if (fixed != NULL) {
+        fixed_encode = isa_active() >= ISA_POPCNT ? fixed->encode_popcnt : fixed->encode;
+        encoders.push_back(HSIAO_ENCODER_FIXED);
+    }
+    if (kernel.Built()) {
+        encoders.push_back(HSIAO_ENCODER_TABLE);
+    }
+    encoders.push_back(HSIAO_ENCODER_ROWS);
+    encoder = encoders[0];
+    if (fixed != NULL) {
+        dense_positions = fixed->positions;
+    } else if (k <= HSIAO_DENSE_MAP_MAX_BITS) {
+        position_map.assign((size_t)1 << k, HSIAO_NO_POSITION);
+        position_map_mask = position_map.size() - 1;
+        for (int ci = 0; ci < n; ci++) {
+            position_map[column_syndromes[ci].w[0]] = ci;
+        }
+        dense_positions = position_map.data();
+    } else {
+        // at most half full
+        dense_positions = NULL;
+        size_t size = 1;
+        while (size < 2 * (size_t)n) {
+            size *= 2;
+        }
+        position_map.assign(size, HSIAO_NO_POSITION);
+        position_map_mask = size - 1;
+        for (int ci = 0; ci < n; ci++) {
+            uint64_t slot = SyndromeHash(column_syndromes[ci]) & position_map_mask;
+            while (position_map[slot] != HSIAO_NO_POSITION) {
+                slot = (slot + 1) & position_map_mask;
+            }
+            position_map[slot] = ci;
+        }
+    }
 }
 
 ECCMethod_Hsiao::~ECCMethod_Hsiao()
@@ -58,6 +133,20 @@ ECCMethod_Hsiao::~ECCMethod_Hsiao()
     // pass
 }
 
+std::vector<ecc_syndrome> ECCMethod_Hsiao::ConstructColumns(int d, int k, bool debug_print)
+{
+    matrix hsiao_code = matrix_construction(d, k, debug_print);
+    std::vector<ecc_syndrome> columns(d + k);
+    for (int ri = 0; ri < k; ri++) {
+        for (int ci = 0; ci < d + k; ci++) {
+            if (hsiao_code.d[ri][ci] != 0) {
+                columns[ci].flip(ri);
+            }
+        }
+    }
+    return columns;
+}
+
 uint32_t ECCMethod_Hsiao::DataWidth()
 {
     return d;
@@ -68,99 +157,225 @@ uint32_t ECCMethod_Hsiao::ECCWidth()
     return k;
 }
 
-void ECCMethod_Hsiao::ConstructECC(std::vector<bool>& data, std::vector<bool>& ecc)
+template <uint32_t WORDS>
+ISA_INLINE void ECCMethod_Hsiao::ConstructECCRows(const uint64_t* data, uint64_t* ecc)
 {
-    ecc.assign(ECCWidth(), 0);
-    for (int ci = 0; ci < d; ci++) {
-        for (int ri = 0; ri < k; ri++) {
-            if (parity_matrix_by_columns[ci][ri] == true) {
-                ecc[ri] = ecc[ri] ^ data[ci];
-            }
+    // every ecc bit is the parity of its row masked data, WORDS > 0 fixes the data word count for the common widths
+    const uint32_t words = WORDS > 0 ? WORDS : data_words;
+    for (uint32_t wi = 0; wi < ecc_packed_words(k); wi++) {
+        ecc[wi] = 0;
+    }
+    for (int ri = 0; ri < k; ri++) {
+        uint32_t ones = 0;
+        for (uint32_t wi = 0; wi < words; wi++) {
+            ones += __builtin_popcountll(data[wi] & row_masks[wi * k + ri]);
         }
+        ecc[ri / 64] |= (uint64_t)(ones & 0b1) << (ri % 64);
     }
 }
 
-ECC_DETECTION ECCMethod_Hsiao::CheckAndCorrect(std::vector<bool>& data, std::vector<bool>& ecc)
+template <uint32_t WORDS>
+ISA_TARGET_POPCNT void ECCMethod_Hsiao::ConstructECCRowsPopcnt(const uint64_t* data, uint64_t* ecc)
 {
-    std::vector<bool> syndrome(k, false);
-    for (int ci = 0; ci < d; ci++) {
-        for (int ri = 0; ri < k; ri++) {
-            if (parity_matrix_by_columns[ci][ri] == true) {
-                syndrome[ri] = syndrome[ri] ^ data[ci];
-            }
-        }
+    ConstructECCRows<WORDS>(data, ecc);
+}
+
+template <uint32_t WORDS>
+ISA_TARGET_AVX512 void ECCMethod_Hsiao::ConstructECCRowsAVX512(const uint64_t* data, uint64_t* ecc)
+{
+    // 8 rows per vector, the rows of one data word are adjacent
+    const uint32_t words = WORDS > 0 ? WORDS : data_words;
+    for (uint32_t wi = 0; wi < ecc_packed_words(k); wi++) {
+        ecc[wi] = 0;
     }
-    bool zero = true;
-    int mmcnt = 0;
-    for (int ei = 0; ei < k; ei++) {
-        bool match = (ecc[ei] == syndrome[ei]);
-        if (!match) {
-            zero = false;
-            mmcnt++;
-        }
-        if (debug_print) {
-            printf("bit:%i %s\n", ei, match ? "match" : "fail");
+    for (int ri = 0; ri < k; ri += 8) {
+        __mmask8 rows = k - ri >= 8 ? 0xFF : (1 << (k - ri)) - 1;
+        __m512i ones = _mm512_setzero_si512();
+        for (uint32_t wi = 0; wi < words; wi++) {
+            __m512i masked = _mm512_and_si512(_mm512_maskz_loadu_epi64(rows, &row_masks[wi * k + ri]), _mm512_set1_epi64(data[wi]));
+            ones = _mm512_add_epi64(ones, _mm512_popcnt_epi64(masked));
         }
+        uint64_t parity = _mm512_test_epi64_mask(ones, _mm512_set1_epi64(1));
+        ecc[ri / 64] |= parity << (ri % 64);
     }
-    if (debug_print) {
-        printf("%i fails\n", mmcnt);
+}
+
+template <uint32_t WORDS>
+void ECCMethod_Hsiao::SelectConstructRows()
+{
+    if (isa_active() >= ISA_AVX512) {
+        construct_rows = &ECCMethod_Hsiao::ConstructECCRowsAVX512<WORDS>;
+    } else if (isa_active() >= ISA_POPCNT) {
+        construct_rows = &ECCMethod_Hsiao::ConstructECCRowsPopcnt<WORDS>;
+    } else {
+        construct_rows = &ECCMethod_Hsiao::ConstructECCRows<WORDS>;
     }
-    if (zero == true) {
-        return ECC_DETECTION_OK;
+}
+
+ISA_INLINE void ECCMethod_Hsiao::EncodeWord(const uint64_t* data, uint64_t* ecc)
+{
+    switch (encoder) {
+        case HSIAO_ENCODER_FIXED:
+            fixed_encode(data, ecc);
+            break;
+        case HSIAO_ENCODER_TABLE:
+            kernel.Encode(data, ecc);
+            break;
+        default:
+            (this->*construct_rows)(data, ecc);
+            break;
     }
-    if ((mmcnt & 0b1) == 0b0) {
-        // even non-zero syndrome
-        return ECC_DETECTION_UNCORRECTABLE;
+}
+
+void ECCMethod_Hsiao::ConstructECCPacked(const uint64_t* data, uint64_t* ecc)
+{
+    EncodeWord(data, ecc);
+}
+
+ECC_DETECTION ECCMethod_Hsiao::CheckAndCorrectPacked(uint64_t* data, uint64_t* ecc, uint32_t* corrections, uint32_t& correction_count)
+{
+    correction_count = 0;
+    ecc_syndrome syndrome;
+    ECCMethod_Hsiao::ConstructECCPacked(data, syndrome.w);
+    for (uint32_t wi = 0; wi < ecc_packed_words(k); wi++) {
+        syndrome.w[wi] ^= ecc[wi];
     }
-    // correct error at syndrome
-    // bitwise conjuction of all the rows containing missmatches in the syndrome, remaining bits are positions to flip
-    std::vector<bool> row_conjuction(n, true);
-    if (mmcnt == 1) {
-        // fail is within ecc bits, unset all non parity bits
-        std::replace(row_conjuction.begin(), row_conjuction.begin() + d, true, false);
+    if (debug_print) {
+        for (int ei = 0; ei < k; ei++) {
+            printf("bit:%i %s\n", ei, syndrome.get(ei) ? "fail" : "match");
+        }
+        printf("%u fails\n", syndrome.weight());
     }
-    for (int ei = 0; ei < k; ei++) {
-        for (int ci = 0; ci < n; ci++) {
-            if (ecc[ei] != syndrome[ei]) {
-                row_conjuction[ci] = row_conjuction[ci] && parity_matrix_by_rows[ei][ci];
-            } else if (parity_matrix_by_rows[ei][ci] == 1) {
-                row_conjuction[ci] = 0; // we don't really need to do this, we could also just stop flipping after the first bit has been flipped, but this cleans up the conjuction so there is just the one bit left in the mask
-            }
+    ECC_DETECTION ret;
+    if (decode_table != NULL) {
+        // single lookup instead of the column search
+        ret = decode_table->Decode(syndrome.w[0], corrections, correction_count);
+    } else {
+        ret = ECCMethod_Hsiao::DecodeSyndrome(syndrome, corrections, correction_count);
+    }
+    if (ret == ECC_DETECTION_CORRECTED) {
+        uint32_t ci = corrections[0];
+        if (ci < (uint32_t)d) {
+            data[ci / 64] ^= (uint64_t)1 << (ci % 64);
+        } else {
+            ecc[(ci - d) / 64] ^= (uint64_t)1 << ((ci - d) % 64);
         }
     }
-    if (debug_print) {
-        printf("row conjunction (excluding impossible combinations):\n");
+    return ret;
+}
+
+void ECCMethod_Hsiao::ConstructECCBatch(const uint64_t* data, uint64_t* ecc, uint32_t count)
+{
+    uint32_t ecc_words = ecc_packed_words(k);
+    uint64_t data_word[data_words];
+    uint64_t ecc_word[ecc_words];
+    for (uint32_t c = 0; c < count; c++) {
+        for (uint32_t w = 0; w < data_words; w++) {
+            data_word[w] = data[w * count + c];
+        }
+        EncodeWord(data_word, ecc_word);
+        for (uint32_t w = 0; w < ecc_words; w++) {
+            ecc[w * count + c] = ecc_word[w];
+        }
     }
-    bool corrected = false;
-    for (int ci = 0; ci < n; ci++) {
-        if (row_conjuction[ci] == true && !corrected) {
-            if (ci < n - k) {
-                data[ci] = !data[ci];
-            } else {
-                ecc[ci - d] = !ecc[ci - d];
-            }
-            corrected = true;
-            if (!debug_print) {
-                break;
-            }
+}
+
+void ECCMethod_Hsiao::CheckAndCorrectBatch(uint64_t* data, uint64_t* ecc, uint32_t count, ECC_DETECTION* detections, uint32_t* corrections, uint32_t* correction_counts)
+{
+    uint32_t ecc_words = ecc_packed_words(k);
+    batch_syndromes.resize(ecc_words * count);
+    ECCMethod_Hsiao::ConstructECCBatch(data, batch_syndromes.data(), count);
+    for (uint32_t c = 0; c < count; c++) {
+        ecc_syndrome syndrome;
+        for (uint32_t w = 0; w < ecc_words; w++) {
+            syndrome.w[w] = batch_syndromes[w * count + c] ^ ecc[w * count + c];
         }
-        if (debug_print) {
-            if (ci == n - k) {
-                printf(" ");
+        uint32_t* codeword_corrections = &corrections[c];
+        if (decode_table != NULL) {
+            detections[c] = decode_table->Decode(syndrome.w[0], codeword_corrections, correction_counts[c]);
+        } else {
+            detections[c] = ECCMethod_Hsiao::DecodeSyndrome(syndrome, codeword_corrections, correction_counts[c]);
+        }
+        if (detections[c] == ECC_DETECTION_CORRECTED) {
+            uint32_t ci = codeword_corrections[0];
+            if (ci < (uint32_t)d) {
+                data[(ci / 64) * count + c] ^= (uint64_t)1 << (ci % 64);
+            } else {
+                ecc[((ci - d) / 64) * count + c] ^= (uint64_t)1 << ((ci - d) % 64);
             }
-            printf("%c", row_conjuction[ci] ? '1' : '0');
         }
     }
-    if (debug_print) {
-        printf("\n");
+}
+
+bool ECCMethod_Hsiao::BoundedDistance()
+{
+    return true;
+}
+
+ecc_syndrome ECCMethod_Hsiao::ColumnSyndrome(uint32_t position)
+{
+    return column_syndromes[position];
+}
+
+ECC_DETECTION ECCMethod_Hsiao::DecodeSyndrome(const ecc_syndrome& syndrome, uint32_t* corrections, uint32_t& correction_count)
+{
+    correction_count = 0;
+    if (syndrome.zero()) {
+        return ECC_DETECTION_OK;
     }
-    if (!corrected) {
-        // if the syndrom was invalid and did not point to a correctable failure, we can detect this because no bit was flipped
+    if ((syndrome.weight() & 0b1) == 0b0) {
+        // even non-zero syndrome
+        return ECC_DETECTION_UNCORRECTABLE;
+    }
+    // the row conjuction of the mismatching rows leaves exactly the column equal to the syndrome
+    uint32_t ci = LookupPosition(syndrome);
+    if (ci == HSIAO_NO_POSITION) {
         return ECC_DETECTION_UNCORRECTABLE;
     }
+    corrections[correction_count++] = ci;
     return ECC_DETECTION_CORRECTED;
 }
 
+uint32_t ECCMethod_Hsiao::EncoderVariantCount()
+{
+    return encoders.size();
+}
+
+const char* ECCMethod_Hsiao::EncoderVariantName(uint32_t variant)
+{
+    static const char* const NAMES[] = {"fixed", "table", "rows"};
+    return NAMES[encoders[variant]];
+}
+
+void ECCMethod_Hsiao::SetEncoderVariant(uint32_t variant)
+{
+    assert(variant < EncoderVariantCount());
+    encoder = encoders[variant];
+}
+
+uint64_t ECCMethod_Hsiao::SyndromeHash(const ecc_syndrome& syndrome)
+{
+    uint64_t h = 0;
+    for (uint32_t wi = 0; wi < ECC_SYNDROME_MAX_BITS / 64; wi++) {
+        h = (h ^ syndrome.w[wi]) * 0x9E3779B97F4A7C15;
+        h ^= h >> 29;
+    }
+    return h;
+}
+
+uint32_t ECCMethod_Hsiao::LookupPosition(const ecc_syndrome& syndrome)
+{
+    if (k <= HSIAO_DENSE_MAP_MAX_BITS) {
+        return dense_positions[syndrome.w[0]];
+    }
+    for (uint64_t slot = SyndromeHash(syndrome) & position_map_mask;; slot = (slot + 1) & position_map_mask) {
+        uint32_t ci = position_map[slot];
+        if (ci == HSIAO_NO_POSITION || column_syndromes[ci] == syndrome) {
+            return ci;
+        }
+    }
+}
+
 ECCMethod_Hsiao::matrix::matrix(int rows, int cols, int fill_elem):
     rows(rows),
     cols(cols)
@@ -184,9 +399,9 @@ std::vector<int>& ECCMethod_Hsiao::matrix::operator[](int ri)
 
 ECCMethod_Hsiao::matrix ECCMethod_Hsiao::matrix::select_rows(std::vector<int> row_indices)
 {
-    assert(row_indices.size() == rows);
+    assert(row_indices.size() == (size_t)rows);
     matrix result(row_indices.size(), cols);
-    for (int i = 0; i < row_indices.size(); ++i) {
+    for (size_t i = 0; i < row_indices.size(); ++i) {
         assert(row_indices[i] >= 0 && row_indices[i] < rows);
         result[i] = d[row_indices[i]];
     }
@@ -199,14 +414,14 @@ ECCMethod_Hsiao::matrix ECCMethod_Hsiao::matrix::hstack(std::vector<matrix> part
     int out_cols = 0;
     int row_count = parts[0].rows;
     // check for consistent row count and calculate total column count
-    for (int pi = 0; pi < parts.size(); pi++) {
+    for (size_t pi = 0; pi < parts.size(); pi++) {
         assert(parts[pi].rows == row_count);
         out_cols += parts[pi].cols;
     }
     matrix result(row_count, out_cols);
     // concatenate matrices horizontally
     int col_offset = 0;
-    for (int pi = 0; pi < parts.size(); pi++) {
+    for (size_t pi = 0; pi < parts.size(); pi++) {
         for (int ri = 0; ri < parts[pi].rows; ri++) {
             for (int ci = 0; ci < parts[pi].cols; ci++) {
                 result[ri][col_offset + ci] = parts[pi][ri][ci];
@@ -223,14 +438,14 @@ ECCMethod_Hsiao::matrix ECCMethod_Hsiao::matrix::vstack(std::vector<matrix> part
     int out_rows = 0;
     int col_count = parts[0].cols;
     // check for consistent col count and calculate total row count
-    for (int pi = 0; pi < parts.size(); pi++) {
+    for (size_t pi = 0; pi < parts.size(); pi++) {
         assert(parts[pi].cols == col_count);
         out_rows += parts[pi].rows;
     }
     matrix result(out_rows, col_count);
     // concatenate matrices vertically
     int row_offset = 0;
-    for (int pi = 0; pi < parts.size(); pi++) {
+    for (size_t pi = 0; pi < parts.size(); pi++) {
         for (int ri = 0; ri < parts[pi].rows; ri++) {
             for (int ci = 0; ci < parts[pi].cols; ci++) {
                 result[row_offset + ri][ci] = parts[pi][ri][ci];
@@ -241,7 +456,7 @@ ECCMethod_Hsiao::matrix ECCMethod_Hsiao::matrix::vstack(std::vector<matrix> part
     return result;
 }
 
-ECCMethod_Hsiao::matrix ECCMethod_Hsiao::matrix_construction(int d, int k, bool debug_print)
+ECCMethod_Hsiao::matrix ECCMethod_Hsiao::matrix_construction(int d, int k, bool)
 {
     // generate matrix using contruction algorithm adapted for cpp from https://github.com/msvisser/memory-controller-generator
 
@@ -271,7 +486,7 @@ ECCMethod_Hsiao::matrix ECCMethod_Hsiao::matrix_construction(int d, int k, bool
     return matrix::hstack(parts);
 }
 
-ECCMethod_Hsiao::matrix ECCMethod_Hsiao::matrix_construction_delta(int rows, int cols, int weight, bool debug_print)
+ECCMethod_Hsiao::matrix ECCMethod_Hsiao::matrix_construction_delta(int rows, int cols, int weight, bool)
 {
     // adapted for cpp from https://github.com/msvisser/memory-controller-generator
     // compute delta sub-matrix
@@ -311,7 +526,7 @@ ECCMethod_Hsiao::matrix ECCMethod_Hsiao::matrix_construction_delta(int rows, int
     } else {
         // general case that requires splitting
         assert(2 <= weight && weight <= rows - 2);
-        assert(2 <= cols && cols <= nCr(rows, weight));
+        assert(2 <= cols && (uint64_t)cols <= nCr(rows, weight));
         // recursively calculate sub-parts of the matrix
         int m1 = std::ceil((float)(cols * weight) / (float)rows);
         matrix delta1 = matrix_construction_delta(rows - 1, m1, weight - 1);
@@ -353,13 +568,3 @@ ECCMethod_Hsiao::matrix ECCMethod_Hsiao::matrix_construction_delta(int rows, int
         return matrix::vstack({top, bot});
     }
 }
-
-uint64_t ECCMethod_Hsiao::nCr(uint64_t n, uint64_t r)
-{
-    if (r == 0) {
-        return 1;
-    } else {
-        uint64_t num = n * nCr(n - 1, r - 1);
-        return num / r;
-    }
-}
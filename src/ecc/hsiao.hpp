@@ -4,6 +4,17 @@
 #include <vector>
 
 #include "ecc.hpp"
+#include "fixed_codes.hpp"
+#include "syndrome_kernel.hpp"
+
+static const int HSIAO_DENSE_MAP_MAX_BITS = 16;
+static const uint32_t HSIAO_NO_POSITION = FIXED_CODE_NO_POSITION;
+
+enum HSIAO_ENCODER {
+    HSIAO_ENCODER_FIXED = 0, // unrolled over the compile time matrix of a standard configuration
+    HSIAO_ENCODER_TABLE,
+    HSIAO_ENCODER_ROWS,
+};
 
 class ECCMethod_Hsiao : public ECCMethod {
     // SECDED with hsiao hamming
@@ -16,21 +27,58 @@ class ECCMethod_Hsiao : public ECCMethod {
     int k;
     int d;
 
-    std::vector<std::vector<bool>> parity_matrix_by_rows;
-    std::vector<std::vector<bool>> parity_matrix_by_columns;
+    uint32_t data_words;
+    std::vector<uint64_t> row_masks; // data part of every parity row, [data word][row]
+    void (ECCMethod_Hsiao::*construct_rows)(const uint64_t* data, uint64_t* ecc); // isa variant of ConstructECCRows
+    ECCSyndromeKernel kernel; // only built if its table stays small, the row masks cover the rest
+    const fixed_code* fixed; // NULL unless d/k is a standard configuration
+    void (*fixed_encode)(const uint64_t* data, uint64_t* ecc); // isa variant of the fixed encoder
+    std::vector<HSIAO_ENCODER> encoders; // available encoders in variant order
+    HSIAO_ENCODER encoder;
+
+    std::vector<ecc_syndrome> column_syndromes;
+    // column syndrome to position, dense over all syndromes up to HSIAO_DENSE_MAP_MAX_BITS ecc bits and open addressed above that
+    std::vector<uint32_t> position_map;
+    uint64_t position_map_mask;
+    const uint32_t* dense_positions; // the fixed table or position_map
+    std::vector<uint64_t> batch_syndromes; // scratch of CheckAndCorrectBatch
 
   public:
 
     ECCMethod_Hsiao(int data_bits, int parity_bits, bool debug_print = false);
     ~ECCMethod_Hsiao();
 
+    // column syndromes of the runtime construction, data bits followed by ecc bits
+    static std::vector<ecc_syndrome> ConstructColumns(int d, int k, bool debug_print = false);
+
     uint32_t DataWidth() override;
     uint32_t ECCWidth() override;
-    void ConstructECC(std::vector<bool>& data, std::vector<bool>& ecc) override;
-    ECC_DETECTION CheckAndCorrect(std::vector<bool>& data, std::vector<bool>& ecc) override;
+    void ConstructECCPacked(const uint64_t* data, uint64_t* ecc) override;
+    ECC_DETECTION CheckAndCorrectPacked(uint64_t* data, uint64_t* ecc, uint32_t* corrections, uint32_t& correction_count) override;
+    void ConstructECCBatch(const uint64_t* data, uint64_t* ecc, uint32_t count) override;
+    void CheckAndCorrectBatch(uint64_t* data, uint64_t* ecc, uint32_t count, ECC_DETECTION* detections, uint32_t* corrections, uint32_t* correction_counts) override;
+    bool BoundedDistance() override;
+    ecc_syndrome ColumnSyndrome(uint32_t position) override;
+    ECC_DETECTION DecodeSyndrome(const ecc_syndrome& syndrome, uint32_t* corrections, uint32_t& correction_count) override;
+    uint32_t EncoderVariantCount() override;
+    const char* EncoderVariantName(uint32_t variant) override;
+    void SetEncoderVariant(uint32_t variant) override;
 
   private:
 
+    static uint64_t SyndromeHash(const ecc_syndrome& syndrome);
+    uint32_t LookupPosition(const ecc_syndrome& syndrome);
+
+    template <uint32_t WORDS>
+    void ConstructECCRows(const uint64_t* data, uint64_t* ecc);
+    template <uint32_t WORDS>
+    void ConstructECCRowsPopcnt(const uint64_t* data, uint64_t* ecc);
+    template <uint32_t WORDS>
+    void ConstructECCRowsAVX512(const uint64_t* data, uint64_t* ecc);
+    template <uint32_t WORDS>
+    void SelectConstructRows();
+    void EncodeWord(const uint64_t* data, uint64_t* ecc);
+
     struct matrix {
         int rows;
         int cols;
@@ -46,6 +94,4 @@ class ECCMethod_Hsiao : public ECCMethod {
 
     static matrix matrix_construction(int d, int k, bool debug_print = false);
     static matrix matrix_construction_delta(int rows, int columns, int weight, bool debug_print = false);
-
-    static uint64_t nCr(uint64_t n, uint64_t r);
 };
@@ -0,0 +1,87 @@
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <immintrin.h>
+#include <vector>
+
+#include "ecc.hpp"
+#include "util/isa.hpp"
+
+#include "syndrome_kernel.hpp"
+
+ECCSyndromeKernel::ECCSyndromeKernel()
+{
+}
+
+ECCSyndromeKernel::~ECCSyndromeKernel()
+{
+}
+
+size_t ECCSyndromeKernel::TableBytes(uint32_t data_width, uint32_t ecc_width)
+{
+    return (size_t)((data_width + 7) / 8) * 256 * ecc_packed_words(ecc_width) * sizeof(uint64_t);
+}
+
+void ECCSyndromeKernel::Build(uint32_t data_width, uint32_t ecc_width, const std::vector<ecc_syndrome>& data_columns)
+{
+    assert(ecc_width <= ECC_SYNDROME_MAX_BITS);
+    assert(data_columns.size() >= data_width);
+    chunk_count = (data_width + 7) / 8;
+    ecc_words = ecc_packed_words(ecc_width);
+    table.assign(TableBytes(data_width, ecc_width) / sizeof(uint64_t), 0);
+    for (uint32_t chunk = 0; chunk < chunk_count; chunk++) {
+        // every value extends a smaller one by its highest set bit, bits past the data width never occur in packed words
+        for (uint32_t value = 1; value < 256; value++) {
+            uint32_t high_bit = 31 - __builtin_clz(value);
+            uint32_t bit_pos = chunk * 8 + high_bit;
+            uint64_t* entry = &table[(chunk * 256 + value) * ecc_words];
+            const uint64_t* rest = &table[(chunk * 256 + (value ^ (1 << high_bit))) * ecc_words];
+            for (uint32_t wi = 0; wi < ecc_words; wi++) {
+                entry[wi] = rest[wi] ^ (bit_pos < data_width ? data_columns[bit_pos].w[wi] : 0);
+            }
+        }
+    }
+
+    affine_matrices.clear();
+    if (isa_active() >= ISA_GFNI && ecc_width <= 64) {
+        // output bit i of gf2p8affineqb is the parity of matrix byte 7 - i and the input byte
+        data_words = ecc_packed_words(data_width);
+        ecc_bytes = (ecc_width + 7) / 8;
+        affine_matrices.assign(data_words * ecc_bytes * 8, 0);
+        for (uint32_t bit_pos = 0; bit_pos < data_width; bit_pos++) {
+            uint32_t wi = bit_pos / 64;
+            uint32_t byte = (bit_pos % 64) / 8;
+            for (uint32_t ri = 0; ri < ecc_width; ri++) {
+                if (data_columns[bit_pos].get(ri)) {
+                    uint64_t& matrix = affine_matrices[(wi * ecc_bytes + ri / 8) * 8 + byte];
+                    matrix |= (uint64_t)1 << (8 * (7 - ri % 8) + bit_pos % 8);
+                }
+            }
+        }
+    }
+}
+
+ISA_TARGET_GFNI void ECCSyndromeKernel::EncodeGFNI(const uint64_t* data, uint64_t* ecc) const
+{
+    // lane p transforms all 8 bytes of the data word but only byte p is its own, the others are masked off before folding
+    const __m512i own_bytes = _mm512_set_epi64(0xFF00000000000000, 0xFF000000000000, 0xFF0000000000, 0xFF00000000, 0xFF000000, 0xFF0000, 0xFF00, 0xFF);
+    uint64_t acc = 0;
+    for (uint32_t eb = 0; eb < ecc_bytes; eb++) {
+        __m512i sum = _mm512_setzero_si512();
+        for (uint32_t wi = 0; wi < data_words; wi++) {
+            __m512i matrices = _mm512_loadu_si512(&affine_matrices[(wi * ecc_bytes + eb) * 8]);
+            sum = _mm512_xor_si512(sum, _mm512_gf2p8affine_epi64_epi8(_mm512_set1_epi64(data[wi]), matrices, 0));
+        }
+        uint64_t folded = _mm512_reduce_or_epi64(_mm512_and_si512(sum, own_bytes));
+        folded ^= folded >> 32;
+        folded ^= folded >> 16;
+        folded ^= folded >> 8;
+        acc |= (folded & 0xFF) << (8 * eb);
+    }
+    ecc[0] = acc;
+}
+
+bool ECCSyndromeKernel::Built() const
+{
+    return chunk_count > 0;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "ecc.hpp"
+
+// tables beyond this stop fitting the caches next to the rest of a trial
+static const size_t SYNDROME_KERNEL_MAX_TABLE_BYTES = 256 * 1024;
+
+class ECCSyndromeKernel {
+    // method of four russians for linear codes, the partial syndrome of every value of every 8 bit data chunk is precomputed
+    // so the syndrome of a data word takes one table load and xor per data byte
+
+  private:
+
+    uint32_t chunk_count = 0;
+    uint32_t ecc_words = 0;
+    std::vector<uint64_t> table; // [chunk][byte value][ecc word]
+    // gfni variant for up to 64 ecc bits, [data word][ecc byte][data byte] 8x8 bit matrices, lane p of every 512 bit group maps
+    // data byte p onto the ecc byte
+    uint32_t data_words = 0;
+    uint32_t ecc_bytes = 0;
+    std::vector<uint64_t> affine_matrices;
+
+    void EncodeGFNI(const uint64_t* data, uint64_t* ecc) const;
+
+  public:
+
+    ECCSyndromeKernel();
+    ~ECCSyndromeKernel();
+
+    static size_t TableBytes(uint32_t data_width, uint32_t ecc_width);
+
+    // data_columns holds the syndrome of every single data bit
+    void Build(uint32_t data_width, uint32_t ecc_width, const std::vector<ecc_syndrome>& data_columns);
+    bool Built() const;
+
+    // ecc is fully overwritten with the xor of the columns of the set data bits
+    void Encode(const uint64_t* data, uint64_t* ecc) const
+    {
+        if (!affine_matrices.empty()) {
+            EncodeGFNI(data, ecc);
+            return;
+        }
+        if (ecc_words == 1) {
+            uint64_t acc = 0;
+            for (uint32_t chunk = 0; chunk < chunk_count; chunk++) {
+                acc ^= table[chunk * 256 + ((data[chunk / 8] >> (8 * (chunk % 8))) & 0xFF)];
+            }
+            ecc[0] = acc;
+            return;
+        }
+        for (uint32_t wi = 0; wi < ecc_words; wi++) {
+            ecc[wi] = 0;
+        }
+        for (uint32_t chunk = 0; chunk < chunk_count; chunk++) {
+            const uint64_t* entry = &table[(chunk * 256 + ((data[chunk / 8] >> (8 * (chunk % 8))) & 0xFF)) * ecc_words];
+            for (uint32_t wi = 0; wi < ecc_words; wi++) {
+                ecc[wi] ^= entry[wi];
+            }
+        }
+    }
+};
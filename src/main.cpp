@@ -14,11 +14,20 @@
 #include <unordered_set>
 #include <vector>
 
+#include "analytic/macwilliams.hpp"
+#include "analytic/mitm.hpp"
+#include "analytic/syndrome_dp.hpp"
+#include "analytic/weight_spectrum.hpp"
 #include "ecc/ecc.hpp"
 #include "ecc/bch.hpp"
+#include "ecc/compiled.hpp"
+#include "ecc/decode_table.hpp"
+#include "ecc/fixed_codes.hpp"
 #include "ecc/hamming.hpp"
 #include "ecc/hsiao.hpp"
 
+#include "util/combinations.hpp"
+#include "util/isa.hpp"
 #include "util/noise.h"
 
 static void errorf(const char* fmt, ...)
@@ -30,29 +39,28 @@ static void errorf(const char* fmt, ...)
     exit(-1);
 }
 
-void print_bits(std::vector<bool>& bits)
+void print_bits(const uint64_t* bits, uint32_t bit_count)
 {
-    for (const bool& b : bits) {
-        printf("%c", b ? '1' : '0');
+    for (uint32_t i = 0; i < bit_count; i++) {
+        printf("%c", ((bits[i / 64] >> (i % 64)) & 0b1) ? '1' : '0');
     }
 }
 
-uint64_t nCr(uint64_t n, uint64_t r)
-{
-    if (r == 0) {
-        return 1;
-    } else {
-        uint64_t num = n * nCr(n - 1, r - 1);
-        return num / r;
-    }
-}
+static const size_t SPACED_U128_MAX_STR_SIZE = 53;
 
-static const size_t SPACED_U64_MAX_STR_SIZE = 27;
+// trials per method call of the materialize engine
+static const uint32_t THREAD_WORK_BATCH_SIZE = 1024;
 
-void pre_format_spaced_u64(char* buf, uint64_t n, char space)
+void pre_format_spaced_u128(char* buf, uint128_t n, char space)
 {
-    char temp_buf[32];
-    int temp_len = sprintf(temp_buf, "%lu", n);
+    // printf has no 128 bit conversion, collect the digits backwards
+    char temp_buf[40];
+    int temp_len = 0;
+    do {
+        temp_buf[temp_len++] = '0' + (char)(n % 10);
+        n /= 10;
+    } while (n > 0);
+    std::reverse(temp_buf, temp_buf + temp_len);
 
     int spaces = (temp_len - 1) / 3;
     int out_len = temp_len + spaces;
@@ -72,52 +80,106 @@ void pre_format_spaced_u64(char* buf, uint64_t n, char space)
     }
 }
 
-std::array<uint16_t, 8> bit_position_enumeration_idx_ncr(uint64_t n, uint64_t r, uint64_t idx)
+// the enumerators write the r positions of combination idx to positions
+// a FIXED_R above 0 fixes r at compile time so the small fail counts get unrolled paths, 0 takes runtime_r instead
+template <uint32_t FIXED_R>
+void bit_position_enumeration_idx_ncr(uint64_t n, uint64_t runtime_r, uint128_t idx, uint32_t* positions)
 {
-    std::array<uint16_t, 8> ret;
-    ret.fill(UINT16_MAX);
-    size_t ret_fill = 0;
-    uint64_t n_remaining = n;
-    uint64_t r_remaining = r;
-    uint64_t enumeration = idx;
-    while (r_remaining > 1) {
-        uint64_t bit_block = nCr(n_remaining - 1, r_remaining - 1);
-        if (enumeration < bit_block) {
-            ret[ret_fill++] = n - n_remaining;
-            r_remaining--;
-        } else {
+    const uint64_t r = FIXED_R > 0 ? FIXED_R : runtime_r;
+    if (r == 0) {
+        return;
+    }
+    uint64_t pos = 0;
+    uint128_t enumeration = idx;
+    for (uint64_t slot = 0; slot + 1 < r; slot++) {
+        // skip the blocks of combinations that put a smaller position into this slot
+        while (true) {
+            uint128_t bit_block = nCr128(n - pos - 1, r - slot - 1);
+            if (enumeration < bit_block) {
+                break;
+            }
             enumeration -= bit_block;
+            pos++;
         }
-        n_remaining--;
+        positions[slot] = pos++;
     }
-    ret[ret_fill++] = n - n_remaining + enumeration;
-    return ret;
+    positions[r - 1] = pos + enumeration;
 }
 
-std::array<uint16_t, 8> bit_position_enumeration_idx_burst(uint64_t n, uint64_t r, uint64_t idx)
+template <uint32_t FIXED_R>
+void bit_position_enumeration_idx_burst(uint64_t n, uint64_t runtime_r, uint64_t idx, uint32_t* positions)
 {
-
-    std::array<uint16_t, 8> ret;
-    ret.fill(UINT16_MAX);
+    const uint64_t r = FIXED_R > 0 ? FIXED_R : runtime_r;
     for (size_t ret_idx = 0; ret_idx < r; ret_idx++) {
-        ret[ret_idx] = n - r + 1 + idx + ret_idx;
+        positions[ret_idx] = idx + ret_idx;
     }
-    return ret;
 }
 
-struct ecc_stats {
-    uint64_t detection_ok = 0;
-    uint64_t detection_corrected = 0;
-    uint64_t detection_uncorrectable = 0;
-    uint64_t false_corrections = 0;
-};
-
 enum FAIL_MODE {
     FAIL_MODE_NONE = 0,
     FAIL_MODE_RANDOM,
     FAIL_MODE_RANDOM_BURST,
 };
 
+enum ENGINE {
+    ENGINE_MATERIALIZE = 0, // encode, inject and check real data words
+    ENGINE_SYNDROME, // only track the syndrome of the injected error pattern
+    ENGINE_BITSLICED, // syndromes and outcomes of many trials at once, one trial per bit lane
+    ENGINE_AUTO, // resolved in main, benchmarked by tune_kernel_variant for long runs
+};
+
+static const char* ENGINE_NAMES[] = {"materialize", "syndrome", "bitsliced", "auto"};
+
+enum ANALYTIC {
+    ANALYTIC_DEFAULT = 0, // the one of the least estimated work, see pick_analytic
+    ANALYTIC_DP, // subset sum dp over the syndrome space
+    ANALYTIC_WEIGHTS, // weight distribution from the dual code, bounded distance decoders only
+    ANALYTIC_MITM, // low weight spectrum by meeting in the middle, bounded distance decoders only
+    ANALYTIC_ENUMERATE, // plain full run, only picked by the default
+};
+
+// rough costs on one core, measured on hsiao 200/22 to 200/26, bch 50/5 and bch 96/5
+static const double ANALYTIC_DP_UPDATE_NS = 3; // per column, layer and syndrome
+static const double ANALYTIC_WEIGHTS_WORD_NS = 7; // per dual codeword and 64 bit word of it
+static const double ANALYTIC_MITM_VISIT_NS = 70; // per visited half pattern, see mitm_visit_count
+static const double ANALYTIC_TRIAL_NS = 15; // per trial and squared correction capability, plus one
+static const double ANALYTIC_DP_PREFERRED_NS = 1e9; // the dp is picked below this even if another run is cheaper
+
+// analytic run of the least estimated work among the ones that support the method, enumerating the fault combinations included
+static ANALYTIC pick_analytic(ECCMethod* method, uint32_t fail_count)
+{
+    const uint32_t word_width = method->DataWidth() + method->ECCWidth();
+    const uint32_t ecc_width = method->ECCWidth();
+    const uint32_t radius = method->CorrectionCapability();
+    const uint32_t max_weight = std::min(fail_count + radius, word_width);
+
+    ANALYTIC best = ANALYTIC_ENUMERATE;
+    double best_ns = ANALYTIC_TRIAL_NS * (1 + radius * radius) * (double)nCr128(word_width, fail_count);
+    if (method->BoundedDistance() && macwilliams_fits(method, fail_count + radius)) {
+        double weights_ns = ANALYTIC_WEIGHTS_WORD_NS * ecc_packed_words(word_width) * std::ldexp(1.0, ecc_width);
+        if (weights_ns < best_ns) {
+            best = ANALYTIC_WEIGHTS;
+            best_ns = weights_ns;
+        }
+    }
+    if (method->BoundedDistance() && ecc_width <= MITM_MAX_SYNDROME_BITS && method->PaddingWidth() == 0) {
+        // tables past the memory budget take several passes, each enumerating the prefixes of the halves again
+        double mitm_ns = ANALYTIC_MITM_VISIT_NS * mitm_visit_count(method, max_weight, 1);
+        if (mitm_ns < best_ns) {
+            best = ANALYTIC_MITM;
+            best_ns = mitm_ns;
+        }
+    }
+    // the dp also tracks the flip occurences, so it is kept while it stays short
+    if (ECCDecodeTable::Fits(method) && syndrome_dp_fits(method, fail_count)) {
+        double dp_ns = ANALYTIC_DP_UPDATE_NS * word_width * std::max(fail_count, 1u) * std::ldexp(1.0, ecc_width);
+        if (dp_ns < std::max(best_ns, ANALYTIC_DP_PREFERRED_NS)) {
+            best = ANALYTIC_DP;
+        }
+    }
+    return best;
+}
+
 struct thread_control {
     pthread_t pthread_id;
     bool full_run;
@@ -125,14 +187,176 @@ struct thread_control {
     uint32_t fail_count;
     uint64_t rng_seed;
     ECCMethod* method;
-    uint64_t work_offset;
-    uint64_t work_progress;
-    uint64_t work_max;
+    const ECCDecodeTable* decode_table; // shared by all threads, NULL if the method does not fit one
+    bool power_syndromes; // syndrome workers only, set by load_column_syndromes
+    ENGINE engine;
+    uint32_t lanes; // bitsliced engine only
+    uint128_t work_offset;
+    uint64_t work_stride; // depth first runs only, work_offset is the first root and work_max the node count
+    uint128_t work_progress;
+    uint128_t work_max;
     ecc_stats stats;
+    std::vector<ecc_stats> fail_count_stats; // depth first runs only, indexed by fail count
     std::vector<uint64_t> flip_occurence_counts;
     std::vector<int64_t> flip_occurence_flip_avg_distances;
 };
 
+template <uint32_t FIXED_R>
+uint32_t generate_fail_positions_fixed(thread_control& ctrl, uint32_t word_width, uint128_t idx, uint64_t& rctr, uint32_t* fail_positions)
+{
+    const uint32_t fail_count = FIXED_R > 0 ? FIXED_R : ctrl.fail_count;
+    uint32_t total_positions = word_width;
+    uint32_t generated_bits = 0;
+
+    switch (ctrl.fail_mode) {
+        case FAIL_MODE_NONE: {
+            //pass
+        } break;
+        case FAIL_MODE_RANDOM: {
+            if (ctrl.full_run) {
+                bit_position_enumeration_idx_ncr<FIXED_R>(word_width, fail_count, idx, fail_positions);
+                generated_bits = fail_count;
+            } else {
+                while (generated_bits < fail_count) {
+                    uint32_t flip_pos = noise_get_u64n(rctr++, ctrl.rng_seed, total_positions);
+                    bool unique = true;
+                    for (uint32_t test_bit = 0; test_bit < generated_bits; test_bit++) {
+                        if (fail_positions[test_bit] == flip_pos) {
+                            unique = false;
+                        }
+                    }
+                    if (!unique) {
+                        continue;
+                    }
+                    fail_positions[generated_bits++] = flip_pos;
+                }
+            }
+        } break;
+        case FAIL_MODE_RANDOM_BURST: {
+            if (ctrl.full_run) {
+                bit_position_enumeration_idx_burst<FIXED_R>(word_width, fail_count, idx, fail_positions);
+                generated_bits = fail_count;
+            } else {
+                total_positions -= fail_count - 1;
+                uint32_t flip_pos = noise_get_u64n(rctr++, ctrl.rng_seed, total_positions);
+                while (generated_bits < fail_count) {
+                    fail_positions[generated_bits] = flip_pos + generated_bits;
+                    generated_bits++;
+                }
+            }
+        } break;
+        default: {
+            printf("invalid fail mode\n");
+            assert(0);
+            exit(-1);
+        } break;
+    }
+    return generated_bits;
+}
+
+// fills fail_positions for test idx, returns the number of generated positions
+uint32_t generate_fail_positions(thread_control& ctrl, uint32_t word_width, uint128_t idx, uint64_t& rctr, uint32_t* fail_positions)
+{
+    // small fail counts get their own instantiations, everything above goes through the runtime sized path
+    switch (ctrl.fail_count) {
+        case 1:
+            return generate_fail_positions_fixed<1>(ctrl, word_width, idx, rctr, fail_positions);
+        case 2:
+            return generate_fail_positions_fixed<2>(ctrl, word_width, idx, rctr, fail_positions);
+        case 3:
+            return generate_fail_positions_fixed<3>(ctrl, word_width, idx, rctr, fail_positions);
+        case 4:
+            return generate_fail_positions_fixed<4>(ctrl, word_width, idx, rctr, fail_positions);
+        case 5:
+            return generate_fail_positions_fixed<5>(ctrl, word_width, idx, rctr, fail_positions);
+        case 6:
+            return generate_fail_positions_fixed<6>(ctrl, word_width, idx, rctr, fail_positions);
+        case 7:
+            return generate_fail_positions_fixed<7>(ctrl, word_width, idx, rctr, fail_positions);
+        case 8:
+            return generate_fail_positions_fixed<8>(ctrl, word_width, idx, rctr, fail_positions);
+        default:
+            return generate_fail_positions_fixed<0>(ctrl, word_width, idx, rctr, fail_positions);
+    }
+}
+
+// records a decoder outcome with its correction set into stats and the flip occurences of ctrl
+void record_outcome(thread_control& ctrl, ECC_DETECTION detection, const uint32_t* fail_positions, uint32_t generated_bits, const uint32_t* corrections, uint32_t correction_count, ecc_stats& stats, bool print_tests)
+{
+    switch (detection) {
+        case ECC_DETECTION_OK: {
+            stats.detection_ok++;
+            if (print_tests) {
+                printf("detection: ok\n");
+                if (ctrl.fail_mode != FAIL_MODE_NONE && generated_bits > 0) {
+                    printf("completely silent corruption\n");
+                }
+            }
+        } break;
+        case ECC_DETECTION_CORRECTED: {
+            stats.detection_corrected++;
+            if (print_tests) {
+                printf("detection: corrected at:");
+            }
+            // the correction was right iff it flipped exactly the injected positions
+            bool correct_correction = correction_count == generated_bits;
+            for (uint32_t ci = 0; ci < correction_count; ci++) {
+                uint32_t bit_pos = corrections[ci];
+                bool injected = false;
+                ctrl.flip_occurence_counts[bit_pos]++;
+                for (uint32_t fault_idx = 0; fault_idx < generated_bits; fault_idx++) {
+                    ctrl.flip_occurence_flip_avg_distances[bit_pos] += (int64_t)bit_pos - (int64_t)fail_positions[fault_idx];
+                    injected |= fail_positions[fault_idx] == bit_pos;
+                }
+                correct_correction &= injected;
+                if (print_tests) {
+                    printf(" %u%s", bit_pos, ci + 1 < correction_count ? "," : "");
+                }
+            }
+            if (print_tests) {
+                printf("\n");
+            }
+            if (!correct_correction) {
+                stats.false_corrections++;
+                if (print_tests) {
+                    printf("correction failed\n");
+                }
+            }
+        } break;
+        case ECC_DETECTION_UNCORRECTABLE: {
+            stats.detection_uncorrectable++;
+            if (print_tests) {
+                printf("detection: uncorrectable\n");
+            }
+        } break;
+        default: {
+            printf("invalid detection\n");
+            assert(0);
+            exit(-1);
+        } break;
+    }
+}
+
+// prints the word with the given positions marked below it
+void print_marked_word(const uint64_t* data, uint32_t data_width, const uint64_t* ecc, uint32_t ecc_width, const uint32_t* positions, uint32_t position_count)
+{
+    print_bits(data, data_width);
+    printf(" ");
+    print_bits(ecc, ecc_width);
+    printf("\n");
+    for (uint32_t bit_pos = 0; bit_pos < data_width + ecc_width; bit_pos++) {
+        if (bit_pos == data_width) {
+            printf(" ");
+        }
+        bool marked = false;
+        for (uint32_t i = 0; i < position_count; i++) {
+            marked |= positions[i] == bit_pos;
+        }
+        printf("%c", marked ? '|' : '-');
+    }
+    printf("\n");
+}
+
 void* thread_work(void* arg)
 {
     thread_control& ctrl = *(thread_control*)arg;
@@ -148,241 +372,595 @@ void* thread_work(void* arg)
     ctrl.flip_occurence_counts.resize(word_width, 0);
     ctrl.flip_occurence_flip_avg_distances.resize(word_width, 0);
 
-    std::vector<bool> data;
-    data.resize(data_width);
-    std::vector<bool> ecc;
-    ecc.resize(ecc_width);
-
-    std::vector<bool> data_check = data;
-    std::vector<bool> ecc_check = ecc;
+    std::vector<uint64_t> data(ecc_packed_words(data_width), 0);
+    std::vector<uint64_t> ecc(ecc_packed_words(ecc_width), 0);
 
     // randomize initial data
-    for (uint32_t i = 0; i < data.size(); i++) {
-        data[i] = squirrelnoise5_u64(rctr++, ctrl.rng_seed) & 0b1;
-    }
-    // zero ecc
-    for (uint32_t i = 0; i < data.size(); i++) {
-        ecc[i] = 0;
+    for (uint32_t i = 0; i < data_width; i++) {
+        data[i / 64] |= (squirrelnoise5_u64(rctr++, ctrl.rng_seed) & 0b1) << (i % 64);
     }
 
-    for (uint64_t t = 0; ctrl.work_offset + t < ctrl.work_max; t++) {
-        uint64_t effective_bp_idx = ctrl.work_offset + t;
-        if (print_tests) {
-            printf("\n\n");
-        } else if ((t & UINT16_MAX) == 0) {
+    // trials run in batches of codewords so the method calls and their setup are shared, printed runs go one trial at a time to keep
+    // the output in order, every batch starts from the data the previous one ended with
+    const uint32_t batch_size = print_tests ? 1 : THREAD_WORK_BATCH_SIZE;
+    uint32_t data_words = ecc_packed_words(data_width);
+    uint32_t ecc_words = ecc_packed_words(ecc_width);
+    uint32_t correction_capability = ctrl.method->CorrectionCapability();
+    std::vector<uint64_t> batch_data(data_words * batch_size);
+    std::vector<uint64_t> batch_ecc(ecc_words * batch_size);
+    std::vector<uint32_t> batch_fail_positions(ctrl.fail_count * batch_size);
+    std::vector<uint32_t> batch_generated_bits(batch_size);
+    std::vector<ECC_DETECTION> detections(batch_size);
+    std::vector<uint32_t> corrections(correction_capability * batch_size);
+    std::vector<uint32_t> correction_counts(batch_size);
+
+    for (uint128_t t = 0; ctrl.work_offset + t < ctrl.work_max; t += batch_size) {
+        uint32_t count = std::min((uint128_t)batch_size, ctrl.work_max - ctrl.work_offset - t);
+        if (!print_tests && (t & UINT16_MAX) == 0) {
             ctrl.work_progress = t;
         }
         // rebuild ecc
-        ctrl.method->ConstructECC(data, ecc);
-        data_check = data;
-        ecc_check = ecc;
-        // inject bit faults
-        uint32_t fail_positions[ctrl.fail_count];
-        uint32_t total_positions = word_width;
-        uint32_t generated_bits = 0;
-
-        switch (ctrl.fail_mode) {
-            case FAIL_MODE_NONE: {
-                //pass
-            } break;
-            case FAIL_MODE_RANDOM: {
-                if (ctrl.full_run) {
-                    std::array<uint16_t, 8> bit_positions = bit_position_enumeration_idx_ncr(word_width, ctrl.fail_count, effective_bp_idx);
-                    for (; generated_bits < ctrl.fail_count; generated_bits++) {
-                        fail_positions[generated_bits] = bit_positions[generated_bits];
-                    }
-                } else {
-                    while (generated_bits < ctrl.fail_count) {
-                        uint32_t flip_pos = noise_get_u64n(rctr++, ctrl.rng_seed, total_positions);
-                        bool unique = true;
-                        for (uint32_t test_bit = 0; test_bit < generated_bits; test_bit++) {
-                            if (fail_positions[test_bit] == flip_pos) {
-                                unique = false;
-                            }
-                        }
-                        if (!unique) {
-                            continue;
-                        }
-                        fail_positions[generated_bits++] = flip_pos;
+        for (uint32_t w = 0; w < data_words; w++) {
+            std::fill(&batch_data[w * count], &batch_data[w * count] + count, data[w]);
+        }
+        ctrl.method->ConstructECCBatch(batch_data.data(), batch_ecc.data(), count);
+
+        for (uint32_t c = 0; c < count; c++) {
+            // inject bit faults
+            uint32_t* fail_positions = &batch_fail_positions[c * ctrl.fail_count];
+            uint32_t generated_bits = generate_fail_positions(ctrl, word_width, ctrl.work_offset + t + c, rctr, fail_positions);
+            batch_generated_bits[c] = generated_bits;
+
+            // print original data and ecc
+            if (print_tests) {
+                printf("\n\n");
+                if (generated_bits > 0) {
+                    printf("injecting %u error%s at:", generated_bits, generated_bits > 1 ? "s" : "");
+                    for (uint32_t flipping = 0; flipping < generated_bits; flipping++) {
+                        printf(" %u%s", fail_positions[flipping], flipping + 1 < generated_bits ? "," : "");
                     }
+                    printf("\n");
                 }
-            } break;
-            case FAIL_MODE_RANDOM_BURST: {
-                if (ctrl.full_run) {
-                    std::array<uint16_t, 8> bit_positions = bit_position_enumeration_idx_burst(word_width, ctrl.fail_count, effective_bp_idx);
-                    for (; generated_bits < ctrl.fail_count; generated_bits++) {
-                        fail_positions[generated_bits] = bit_positions[generated_bits];
-                    }
+                print_marked_word(data.data(), data_width, batch_ecc.data(), ecc_width, fail_positions, generated_bits);
+            }
+
+            // flip the bits
+            for (uint32_t flipping = 0; flipping < generated_bits; flipping++) {
+                uint32_t flip_pos = fail_positions[flipping];
+                if (flip_pos < data_width) {
+                    batch_data[(flip_pos / 64) * count + c] ^= (uint64_t)1 << (flip_pos % 64);
                 } else {
-                    total_positions -= ctrl.fail_count - 1;
-                    uint32_t flip_pos = noise_get_u64n(rctr++, ctrl.rng_seed, total_positions);
-                    while (generated_bits < ctrl.fail_count) {
-                        fail_positions[generated_bits] = flip_pos + generated_bits;
-                        generated_bits++;
+                    batch_ecc[((flip_pos - data_width) / 64) * count + c] ^= (uint64_t)1 << ((flip_pos - data_width) % 64);
+                }
+            }
+        }
+
+        // check and correct, the decoder reports what it flipped so the words need no copies or diffs
+        ctrl.method->CheckAndCorrectBatch(batch_data.data(), batch_ecc.data(), count, detections.data(), corrections.data(), correction_counts.data());
+
+        for (uint32_t c = 0; c < count; c++) {
+            uint32_t* codeword_corrections = &corrections[c * correction_capability];
+            // print with errors and the correction flips, then the result, printed batches hold a single codeword
+            if (print_tests) {
+                std::vector<uint64_t> data_fault = batch_data;
+                std::vector<uint64_t> ecc_fault = batch_ecc;
+                for (uint32_t ci = 0; detections[c] == ECC_DETECTION_CORRECTED && ci < correction_counts[c]; ci++) {
+                    if (codeword_corrections[ci] < data_width) {
+                        data_fault[codeword_corrections[ci] / 64] ^= (uint64_t)1 << (codeword_corrections[ci] % 64);
+                    } else {
+                        ecc_fault[(codeword_corrections[ci] - data_width) / 64] ^= (uint64_t)1 << ((codeword_corrections[ci] - data_width) % 64);
                     }
                 }
-            } break;
-            default: {
-                printf("invalid fail mode\n");
-                assert(0);
-                exit(-1);
-            } break;
+                print_marked_word(data_fault.data(), data_width, ecc_fault.data(), ecc_width, codeword_corrections, detections[c] == ECC_DETECTION_CORRECTED ? correction_counts[c] : 0);
+                print_bits(batch_data.data(), data_width);
+                printf(" ");
+                print_bits(batch_ecc.data(), ecc_width);
+                printf("\n");
+            }
+
+            record_outcome(ctrl, detections[c], &batch_fail_positions[c * ctrl.fail_count], batch_generated_bits[c], codeword_corrections, correction_counts[c], ctrl.stats, print_tests);
         }
 
-        // flip the bits
-        if (print_tests && generated_bits > 0) {
-            printf("injecting %u error%s at:", generated_bits, generated_bits > 1 ? "s" : "");
+        for (uint32_t w = 0; w < data_words; w++) {
+            data[w] = batch_data[w * count + count - 1];
+        }
+    }
+
+    ctrl.work_progress = ctrl.work_max - ctrl.work_offset;
+
+    pthread_exit(NULL);
+}
+
+// the syndrome workers xor one column per injected position, the power syndrome columns if the method decodes those directly and no
+// decode table covers the ecc syndrome
+void load_column_syndromes(thread_control& ctrl, uint32_t word_width, std::vector<ecc_syndrome>& column_syndromes)
+{
+    ctrl.power_syndromes = ctrl.decode_table == NULL && ctrl.method->PowerSyndromeWidth() > 0;
+    column_syndromes.resize(word_width);
+    for (uint32_t bit_pos = 0; bit_pos < word_width; bit_pos++) {
+        column_syndromes[bit_pos] = ctrl.power_syndromes ? ctrl.method->PowerColumn(bit_pos) : ctrl.method->ColumnSyndrome(bit_pos);
+    }
+}
+
+// decodes the syndrome of the injected fail_positions and records the outcome into stats and the flip occurences of ctrl
+void record_syndrome_outcome(thread_control& ctrl, const ecc_syndrome& syndrome, const uint32_t* fail_positions, uint32_t generated_bits, uint32_t* corrections, ecc_stats& stats, bool print_tests)
+{
+    uint32_t correction_count = 0;
+    ECC_DETECTION detection;
+    if (ctrl.decode_table != NULL) {
+        detection = ctrl.decode_table->Decode(syndrome.w[0], corrections, correction_count);
+    } else if (ctrl.power_syndromes) {
+        detection = ctrl.method->DecodePowerSyndrome(syndrome, corrections, correction_count);
+    } else {
+        detection = ctrl.method->DecodeSyndrome(syndrome, corrections, correction_count);
+    }
+    record_outcome(ctrl, detection, fail_positions, generated_bits, corrections, correction_count, stats, print_tests);
+}
+
+void* thread_work_syndrome(void* arg)
+{
+    // outcomes of the linear codes only depend on the error pattern (see test_materialization_data_independence)
+    // so instead of materializing words, xor the column syndromes of the injected positions and decode that
+    thread_control& ctrl = *(thread_control*)arg;
+
+    uint32_t data_width = ctrl.method->DataWidth();
+    uint32_t ecc_width = ctrl.method->ECCWidth();
+    uint32_t word_width = data_width + ecc_width;
+
+    // skip the draws thread_work spends on its initial data, so both engines inject the same faults for the same seed
+    uint64_t rctr = data_width;
+
+    const bool print_tests = !ctrl.full_run && (ctrl.work_max - ctrl.work_offset) <= 10;
+
+    ctrl.flip_occurence_counts.resize(word_width, 0);
+    ctrl.flip_occurence_flip_avg_distances.resize(word_width, 0);
+
+    std::vector<ecc_syndrome> column_syndromes;
+    load_column_syndromes(ctrl, word_width, column_syndromes);
+    std::vector<uint32_t> corrections(ctrl.method->CorrectionCapability());
+
+    // full random runs step through their chunk in revolving door order, every step swaps one position so the syndrome follows with two xors
+    const bool revolving_door = ctrl.full_run && ctrl.fail_mode == FAIL_MODE_RANDOM && ctrl.work_offset < ctrl.work_max;
+    RevolvingDoorCombination combination(word_width, revolving_door ? ctrl.fail_count : 0, revolving_door ? ctrl.work_offset : 0);
+    ecc_syndrome syndrome;
+    uint32_t generated_fail_positions[ctrl.fail_count];
+
+    for (uint128_t t = 0; ctrl.work_offset + t < ctrl.work_max; t++) {
+        uint128_t effective_bp_idx = ctrl.work_offset + t;
+        if (print_tests) {
+            printf("\n\n");
+        } else if ((t & UINT16_MAX) == 0) {
+            ctrl.work_progress = t;
         }
-        for (uint32_t flipping = 0; flipping < generated_bits; flipping++) {
-            uint32_t flip_pos = fail_positions[flipping];
-            if (flip_pos < data.size()) {
-                data[flip_pos] = !data[flip_pos];
+        // inject bit faults
+        const uint32_t* fail_positions = generated_fail_positions;
+        uint32_t generated_bits;
+        if (revolving_door) {
+            if (t == 0) {
+                for (uint32_t flipping = 0; flipping < ctrl.fail_count; flipping++) {
+                    syndrome ^= column_syndromes[combination.Positions()[flipping]];
+                }
             } else {
-                ecc[flip_pos - data.size()] = !ecc[flip_pos - data.size()];
+                uint32_t out_pos;
+                uint32_t in_pos;
+                combination.Next(out_pos, in_pos);
+                syndrome ^= column_syndromes[out_pos];
+                syndrome ^= column_syndromes[in_pos];
             }
-            if (print_tests && generated_bits > 0) {
-                printf(" %u", flip_pos);
-                if (flipping + 1 < generated_bits) {
-                    printf(",");
-                }
+            fail_positions = combination.Positions();
+            generated_bits = ctrl.fail_count;
+        } else {
+            generated_bits = generate_fail_positions(ctrl, word_width, effective_bp_idx, rctr, generated_fail_positions);
+            syndrome = ecc_syndrome();
+            for (uint32_t flipping = 0; flipping < generated_bits; flipping++) {
+                syndrome ^= column_syndromes[fail_positions[flipping]];
             }
         }
         if (print_tests && generated_bits > 0) {
+            printf("injecting %u error%s at:", generated_bits, generated_bits > 1 ? "s" : "");
+            for (uint32_t flipping = 0; flipping < generated_bits; flipping++) {
+                printf(" %u%s", fail_positions[flipping], flipping + 1 < generated_bits ? "," : "");
+            }
             printf("\n");
         }
 
-        // print original data and ecc
-        if (print_tests) {
-            print_bits(data_check);
-            printf(" ");
-            print_bits(ecc_check);
-            printf("\n");
-        }
+        // check and correct
+        record_syndrome_outcome(ctrl, syndrome, fail_positions, generated_bits, corrections.data(), ctrl.stats, print_tests);
+    }
 
-        // print flips if wanted
-        for (uint32_t bit_pos = 0; bit_pos < (data.size() + ecc.size()); bit_pos++) {
-            if (print_tests && bit_pos == data.size()) {
-                printf(" ");
+    ctrl.work_progress = ctrl.work_max - ctrl.work_offset;
+
+    pthread_exit(NULL);
+}
+
+// column structure of a single error correcting code for the bitsliced engine
+struct bitsliced_code {
+    uint32_t word_width;
+    uint32_t ecc_width;
+    uint32_t chunk_count; // syndrome rows are matched 4 at a time, every column picks one of the 16 row patterns per chunk
+    std::vector<std::vector<uint32_t>> row_positions;
+    std::vector<uint8_t> column_chunks; // [position][chunk]
+};
+
+// syndromes of the transposed error lanes and their single column matches, lane_corrections is only written for corrected lanes
+template <uint32_t LANE_WORDS>
+ISA_INLINE void bitsliced_classify(const bitsliced_code& code, const uint64_t* errors, uint64_t* syndromes, uint64_t* chunk_matches, uint64_t* nonzero, uint64_t* corrected, uint32_t* lane_corrections)
+{
+    // syndrome rows
+    for (uint32_t lw = 0; lw < LANE_WORDS; lw++) {
+        nonzero[lw] = 0;
+    }
+    for (uint32_t ri = 0; ri < code.ecc_width; ri++) {
+        uint64_t row[LANE_WORDS] = {};
+        for (uint32_t bit_pos : code.row_positions[ri]) {
+            for (uint32_t lw = 0; lw < LANE_WORDS; lw++) {
+                row[lw] ^= errors[bit_pos * LANE_WORDS + lw];
             }
-            bool found = false;
-            for (uint32_t test_bit = 0; test_bit < generated_bits; test_bit++) {
-                if (fail_positions[test_bit] == bit_pos) {
-                    found = true;
-                    break;
-                }
+        }
+        for (uint32_t lw = 0; lw < LANE_WORDS; lw++) {
+            syndromes[ri * LANE_WORDS + lw] = row[lw];
+            nonzero[lw] |= row[lw];
+        }
+    }
+
+    // lanes whose syndrome chunk equals each of the 16 patterns, rows past the ecc width must be zero
+    for (uint32_t chunk = 0; chunk < code.chunk_count; chunk++) {
+        for (uint32_t pattern = 0; pattern < 16; pattern++) {
+            uint64_t* match = &chunk_matches[(chunk * 16 + pattern) * LANE_WORDS];
+            for (uint32_t lw = 0; lw < LANE_WORDS; lw++) {
+                match[lw] = UINT64_MAX;
             }
-            if (!found) {
-                if (print_tests) {
-                    printf("-");
+            for (uint32_t bit = 0; bit < 4; bit++) {
+                uint32_t ri = chunk * 4 + bit;
+                uint64_t flip = ((pattern >> bit) & 0b1) ? 0 : UINT64_MAX;
+                for (uint32_t lw = 0; lw < LANE_WORDS; lw++) {
+                    match[lw] &= (ri < code.ecc_width ? syndromes[ri * LANE_WORDS + lw] : 0) ^ flip;
                 }
-                continue;
             }
-            if (print_tests) {
-                printf("|");
+        }
+    }
+
+    // column matches
+    for (uint32_t lw = 0; lw < LANE_WORDS; lw++) {
+        corrected[lw] = 0;
+    }
+    for (uint32_t bit_pos = 0; bit_pos < code.word_width; bit_pos++) {
+        uint64_t match[LANE_WORDS];
+        uint64_t any = 0;
+        for (uint32_t lw = 0; lw < LANE_WORDS; lw++) {
+            match[lw] = nonzero[lw];
+        }
+        for (uint32_t chunk = 0; chunk < code.chunk_count; chunk++) {
+            const uint64_t* chunk_match = &chunk_matches[(chunk * 16 + code.column_chunks[bit_pos * code.chunk_count + chunk]) * LANE_WORDS];
+            for (uint32_t lw = 0; lw < LANE_WORDS; lw++) {
+                match[lw] &= chunk_match[lw];
             }
         }
-        if (print_tests) {
-            printf("\n");
+        for (uint32_t lw = 0; lw < LANE_WORDS; lw++) {
+            any |= match[lw];
         }
-
-        std::vector<bool> data_fault = data;
-        std::vector<bool> ecc_fault = ecc;
-        // print with errors
-        if (print_tests) {
-            print_bits(data);
-            printf(" ");
-            print_bits(ecc);
-            printf("\n");
+        if (any == 0) {
+            continue;
+        }
+        for (uint32_t lw = 0; lw < LANE_WORDS; lw++) {
+            corrected[lw] |= match[lw];
+            uint64_t lanes = match[lw];
+            while (lanes != 0) {
+                lane_corrections[lw * 64 + __builtin_ctzll(lanes)] = bit_pos;
+                lanes &= lanes - 1;
+            }
         }
+    }
+}
 
-        // check and correct
-        ECC_DETECTION detection = ctrl.method->CheckAndCorrect(data, ecc);
+template <uint32_t LANE_WORDS>
+void bitsliced_classify_scalar(const bitsliced_code& code, const uint64_t* errors, uint64_t* syndromes, uint64_t* chunk_matches, uint64_t* nonzero, uint64_t* corrected, uint32_t* lane_corrections)
+{
+    bitsliced_classify<LANE_WORDS>(code, errors, syndromes, chunk_matches, nonzero, corrected, lane_corrections);
+}
 
-        // print correction flips if wanted
-        for (uint32_t bit_pos = 0; bit_pos < (data_fault.size() + ecc_fault.size()); bit_pos++) {
-            if (print_tests && bit_pos == data_fault.size()) {
-                printf(" ");
+template <uint32_t LANE_WORDS>
+ISA_TARGET_AVX2 void bitsliced_classify_avx2(const bitsliced_code& code, const uint64_t* errors, uint64_t* syndromes, uint64_t* chunk_matches, uint64_t* nonzero, uint64_t* corrected, uint32_t* lane_corrections)
+{
+    bitsliced_classify<LANE_WORDS>(code, errors, syndromes, chunk_matches, nonzero, corrected, lane_corrections);
+}
+
+template <uint32_t LANE_WORDS>
+ISA_TARGET_AVX512 void bitsliced_classify_avx512(const bitsliced_code& code, const uint64_t* errors, uint64_t* syndromes, uint64_t* chunk_matches, uint64_t* nonzero, uint64_t* corrected, uint32_t* lane_corrections)
+{
+    bitsliced_classify<LANE_WORDS>(code, errors, syndromes, chunk_matches, nonzero, corrected, lane_corrections);
+}
+
+template <uint32_t LANE_WORDS>
+void* thread_work_bitsliced(void* arg)
+{
+    // single error correcting bounded distance codes are linear xor networks, so trial t becomes bit t % 64 of the lane words and every
+    // syndrome row is the xor of the lane masks of its positions, a lane is corrected iff its syndrome equals exactly one column
+    thread_control& ctrl = *(thread_control*)arg;
+
+    uint32_t data_width = ctrl.method->DataWidth();
+    uint32_t ecc_width = ctrl.method->ECCWidth();
+    uint32_t word_width = data_width + ecc_width;
+    const uint32_t lane_count = LANE_WORDS * 64;
+
+    // skip the draws thread_work spends on its initial data, so all engines inject the same faults for the same seed
+    uint64_t rctr = data_width;
+
+    const bool print_tests = !ctrl.full_run && (ctrl.work_max - ctrl.work_offset) <= 10;
+
+    ctrl.flip_occurence_counts.resize(word_width, 0);
+    ctrl.flip_occurence_flip_avg_distances.resize(word_width, 0);
+
+    bitsliced_code code;
+    code.word_width = word_width;
+    code.ecc_width = ecc_width;
+    code.chunk_count = (ecc_width + 3) / 4;
+    code.row_positions.resize(ecc_width);
+    code.column_chunks.resize(word_width * code.chunk_count, 0);
+    for (uint32_t bit_pos = 0; bit_pos < word_width; bit_pos++) {
+        ecc_syndrome column = ctrl.method->ColumnSyndrome(bit_pos);
+        for (uint32_t ri = 0; ri < ecc_width; ri++) {
+            if (column.get(ri)) {
+                code.row_positions[ri].push_back(bit_pos);
+                code.column_chunks[bit_pos * code.chunk_count + ri / 4] |= 1 << (ri % 4);
             }
-            bool flipped = false;
-            if (bit_pos < data_fault.size()) {
-                flipped = data[bit_pos] != data_fault[bit_pos];
+        }
+    }
+    void (*classify)(const bitsliced_code&, const uint64_t*, uint64_t*, uint64_t*, uint64_t*, uint64_t*, uint32_t*) = bitsliced_classify_scalar<LANE_WORDS>;
+    if (isa_active() >= ISA_AVX512) {
+        classify = bitsliced_classify_avx512<LANE_WORDS>;
+    } else if (isa_active() >= ISA_AVX2) {
+        classify = bitsliced_classify_avx2<LANE_WORDS>;
+    }
+
+    // lane masks, [position, row or chunk pattern][lane word]
+    std::vector<uint64_t> errors(word_width * LANE_WORDS);
+    std::vector<uint64_t> syndromes(ecc_width * LANE_WORDS);
+    std::vector<uint64_t> chunk_matches(code.chunk_count * 16 * LANE_WORDS);
+
+    // full random runs step through their chunk in revolving door order instead of unranking every trial
+    const bool revolving_door = ctrl.full_run && ctrl.fail_mode == FAIL_MODE_RANDOM && ctrl.work_offset < ctrl.work_max;
+    RevolvingDoorCombination combination(word_width, revolving_door ? ctrl.fail_count : 0, revolving_door ? ctrl.work_offset : 0);
+    std::vector<uint32_t> lane_fail_positions(lane_count * ctrl.fail_count);
+    std::vector<uint32_t> lane_generated_bits(lane_count);
+    std::vector<uint32_t> lane_corrections(lane_count);
+
+    for (uint128_t t = 0; ctrl.work_offset + t < ctrl.work_max; t += lane_count) {
+        uint32_t count = std::min((uint128_t)lane_count, ctrl.work_max - ctrl.work_offset - t);
+        if (!print_tests && (t & UINT16_MAX) == 0) {
+            ctrl.work_progress = t;
+        }
+        // inject bit faults, transposed into the lanes
+        std::fill(errors.begin(), errors.end(), 0);
+        for (uint32_t lane = 0; lane < count; lane++) {
+            uint32_t* fail_positions = &lane_fail_positions[lane * ctrl.fail_count];
+            if (revolving_door) {
+                if (t + lane > 0) {
+                    uint32_t out_pos;
+                    uint32_t in_pos;
+                    combination.Next(out_pos, in_pos);
+                }
+                std::copy(combination.Positions(), combination.Positions() + ctrl.fail_count, fail_positions);
+                lane_generated_bits[lane] = ctrl.fail_count;
             } else {
-                flipped = ecc[bit_pos - data_fault.size()] != ecc_fault[bit_pos - data_fault.size()];
+                lane_generated_bits[lane] = generate_fail_positions(ctrl, word_width, ctrl.work_offset + t + lane, rctr, fail_positions);
             }
-            if (!flipped) {
-                if (print_tests) {
-                    printf("-");
+            for (uint32_t flipping = 0; flipping < lane_generated_bits[lane]; flipping++) {
+                errors[fail_positions[flipping] * LANE_WORDS + lane / 64] ^= (uint64_t)1 << (lane % 64);
+            }
+        }
+
+        uint64_t nonzero[LANE_WORDS];
+        uint64_t corrected[LANE_WORDS];
+        classify(code, errors.data(), syndromes.data(), chunk_matches.data(), nonzero, corrected, lane_corrections.data());
+
+        // classify, lanes past count are all zero and so count as ok
+        if (print_tests) {
+            for (uint32_t lane = 0; lane < count; lane++) {
+                const uint32_t* fail_positions = &lane_fail_positions[lane * ctrl.fail_count];
+                uint32_t generated_bits = lane_generated_bits[lane];
+                printf("\n\n");
+                if (generated_bits > 0) {
+                    printf("injecting %u error%s at:", generated_bits, generated_bits > 1 ? "s" : "");
+                    for (uint32_t flipping = 0; flipping < generated_bits; flipping++) {
+                        printf(" %u%s", fail_positions[flipping], flipping + 1 < generated_bits ? "," : "");
+                    }
+                    printf("\n");
+                }
+                uint64_t lane_bit = (uint64_t)1 << (lane % 64);
+                ECC_DETECTION detection = ECC_DETECTION_UNCORRECTABLE;
+                if ((nonzero[lane / 64] & lane_bit) == 0) {
+                    detection = ECC_DETECTION_OK;
+                } else if ((corrected[lane / 64] & lane_bit) != 0) {
+                    detection = ECC_DETECTION_CORRECTED;
                 }
+                record_outcome(ctrl, detection, fail_positions, generated_bits, &lane_corrections[lane], 1, ctrl.stats, print_tests);
+            }
+            continue;
+        }
+        for (uint32_t lw = 0; lw < LANE_WORDS; lw++) {
+            ctrl.stats.detection_uncorrectable += __builtin_popcountll(nonzero[lw] & ~corrected[lw]);
+            ctrl.stats.detection_ok += __builtin_popcountll(~nonzero[lw]);
+            uint64_t lanes = corrected[lw];
+            while (lanes != 0) {
+                uint32_t lane = lw * 64 + __builtin_ctzll(lanes);
+                record_outcome(ctrl, ECC_DETECTION_CORRECTED, &lane_fail_positions[lane * ctrl.fail_count], lane_generated_bits[lane], &lane_corrections[lane], 1, ctrl.stats, false);
+                lanes &= lanes - 1;
+            }
+        }
+        ctrl.stats.detection_ok -= lane_count - count;
+    }
+
+    ctrl.work_progress = ctrl.work_max - ctrl.work_offset;
+
+    pthread_exit(NULL);
+}
+
+void* thread_work_depth_first(void* arg)
+{
+    // full random runs for every fail count 1..fail_count in one walk over the combination tree
+    // a node at depth d is a d-subset of positions, its syndrome extends its parent's by one xor and it is recorded for fail count d
+    thread_control& ctrl = *(thread_control*)arg;
+
+    uint32_t data_width = ctrl.method->DataWidth();
+    uint32_t ecc_width = ctrl.method->ECCWidth();
+    uint32_t word_width = data_width + ecc_width;
+    const uint32_t max_depth = ctrl.fail_count;
+
+    ctrl.flip_occurence_counts.resize(word_width, 0);
+    ctrl.flip_occurence_flip_avg_distances.resize(word_width, 0);
+    ctrl.fail_count_stats.resize(max_depth + 1);
+
+    std::vector<ecc_syndrome> column_syndromes;
+    load_column_syndromes(ctrl, word_width, column_syndromes);
+    std::vector<uint32_t> corrections(ctrl.method->CorrectionCapability());
+
+    std::vector<uint32_t> positions(max_depth);
+    std::vector<ecc_syndrome> syndromes(max_depth + 1); // syndromes[d] belongs to the first d positions
+
+    // subtrees below the root positions are dealt out round robin, later roots have smaller subtrees
+    uint64_t nodes = 0;
+    for (uint32_t root = ctrl.work_offset; root < word_width && max_depth > 0; root += ctrl.work_stride) {
+        uint32_t depth = 0;
+        positions[0] = root;
+        while (true) {
+            syndromes[depth + 1] = syndromes[depth];
+            syndromes[depth + 1] ^= column_syndromes[positions[depth]];
+            record_syndrome_outcome(ctrl, syndromes[depth + 1], positions.data(), depth + 1, corrections.data(), ctrl.fail_count_stats[depth + 1], false);
+            if ((++nodes & UINT16_MAX) == 0) {
+                ctrl.work_progress = nodes;
+            }
+            // descend if possible, otherwise step to the next sibling or backtrack
+            if (depth + 1 < max_depth && positions[depth] + 1 < word_width) {
+                positions[depth + 1] = positions[depth] + 1;
+                depth++;
                 continue;
             }
-            // add post fault occurence and avg flip distance
-            ctrl.flip_occurence_counts[bit_pos]++;
-            for (uint32_t fault_idx = 0; fault_idx < generated_bits; fault_idx++) {
-                ctrl.flip_occurence_flip_avg_distances[bit_pos] += (int64_t)bit_pos - (int64_t)fail_positions[fault_idx];
+            while (depth > 0 && ++positions[depth] == word_width) {
+                depth--;
             }
-            if (print_tests) {
-                printf("|");
+            if (depth == 0) {
+                break;
             }
         }
-        if (print_tests) {
-            printf("\n");
-        }
+    }
 
-        // print result
-        if (print_tests) {
-            print_bits(data);
-            printf(" ");
-            print_bits(ecc);
-            printf("\n");
+    ctrl.work_progress = ctrl.work_max;
+
+    pthread_exit(NULL);
+}
+
+typedef void* (*work_function)(void*);
+
+work_function engine_work_function(ENGINE engine, uint32_t lanes)
+{
+    if (engine == ENGINE_BITSLICED) {
+        return lanes == 64 ? thread_work_bitsliced<1> : lanes == 256 ? thread_work_bitsliced<4> : thread_work_bitsliced<8>;
+    }
+    return engine == ENGINE_SYNDROME ? thread_work_syndrome : thread_work;
+}
+
+// compile wraps the method into a kernel built for its matrix if it fits one and a compiler is available
+ECCMethod* create_method(const char* name, int d, int k, bool debug_print, bool compile)
+{
+    ECCMethod* method = NULL;
+    if (strcmp(name, "hamming") == 0) {
+        method = new ECCMethod_Hamming();
+    } else if (strcmp(name, "bch") == 0) {
+        method = new ECCMethod_BCH(d, k);
+    } else if (strcmp(name, "hsiao") == 0) {
+        method = new ECCMethod_Hsiao(d, k, debug_print);
+    }
+    if (method != NULL && compile && ECCMethod_Compiled::Fits(method)) {
+        ECCMethod* compiled = ECCMethod_Compiled::Create(method);
+        if (compiled != NULL) {
+            return compiled;
         }
+    }
+    return method;
+}
 
-        // print detection result
-        switch (detection) {
-            case ECC_DETECTION_OK: {
-                ctrl.stats.detection_ok++;
-                if (print_tests) {
-                    printf("detection: ok\n");
-                    if (ctrl.fail_mode != FAIL_MODE_NONE && ctrl.fail_count > 0) {
-                        printf("completely silent corruption\n");
-                    }
-                }
-            } break;
-            case ECC_DETECTION_CORRECTED: {
-                ctrl.stats.detection_corrected++;
-                if (print_tests) {
-                    printf("detection: corrected\n");
-                }
-                bool correct_correction = true;
-                for (uint32_t i = 0; i < data_width; i++) {
-                    correct_correction &= data_check[i] == data[i];
-                }
-                for (uint32_t i = 0; i < ecc_width; i++) {
-                    correct_correction &= ecc_check[i] == ecc[i];
-                }
-                if (!correct_correction) {
-                    ctrl.stats.false_corrections++;
-                    if (print_tests) {
-                        printf("correction failed\n");
-                    }
-                }
-            } break;
-            case ECC_DETECTION_UNCORRECTABLE: {
-                ctrl.stats.detection_uncorrectable++;
-                if (print_tests) {
-                    printf("detection: uncorrectable\n");
-                }
-            } break;
-            default: {
-                printf("invalid detection\n");
-                assert(0);
-                exit(-1);
-            } break;
+// shorter runs are not worth the tuning, which takes about a tenth of a second
+static const uint128_t TUNE_MIN_TRIALS = 1 << 24;
+// every variant runs at least this long
+static const uint64_t TUNE_MIN_NS = 2 * 1000 * 1000;
+
+struct kernel_variant {
+    ENGINE engine;
+    uint32_t lanes; // bitsliced engine only
+    ISA isa;
+    uint32_t encoder; // ECCMethod::SetEncoderVariant
+    uint32_t decoder; // ECCMethod::SetDecoderVariant
+    double trial_ns;
+};
+
+static uint64_t monotonic_ns()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 * 1000 * 1000 + ts.tv_nsec;
+}
+
+// time per trial of the first trials of the run described by base, the run length doubles until it takes TUNE_MIN_NS and the last
+// doubling alone is timed so the per run setup cancels out
+double tune_trial_ns(thread_control base, ECCMethod* method, ENGINE engine, uint32_t lanes, uint128_t max_trials)
+{
+    uint128_t trials = std::min((uint128_t)1024, max_trials);
+    uint128_t prev_trials = 0;
+    uint64_t prev_ns = 0;
+    while (true) {
+        thread_control ctrl = base;
+        ctrl.method = method;
+        ctrl.engine = engine;
+        ctrl.lanes = lanes;
+        ctrl.work_offset = 0;
+        ctrl.work_max = trials;
+        uint64_t start = monotonic_ns();
+        pthread_create(&ctrl.pthread_id, NULL, engine_work_function(engine, lanes), &ctrl);
+        pthread_join(ctrl.pthread_id, NULL);
+        uint64_t ns = monotonic_ns() - start;
+        if (ns >= TUNE_MIN_NS || trials == max_trials) {
+            if (prev_trials > 0 && ns > prev_ns) {
+                return (double)(ns - prev_ns) / (double)(trials - prev_trials);
+            }
+            return (double)ns / (double)trials;
         }
+        prev_trials = trials;
+        prev_ns = ns;
+        trials = std::min(trials * 2, max_trials);
     }
+}
 
-    ctrl.work_progress = ctrl.work_max - ctrl.work_offset;
-
-    pthread_exit(NULL);
+// benchmarks the candidates on fresh instances of the method built for their isa and returns the fastest, leaves isa_active unchanged
+kernel_variant tune_kernel_variant(const thread_control& base, const char* method_name, int d, int k, bool compile, uint128_t max_trials, std::vector<kernel_variant>& candidates)
+{
+    assert(candidates.size() > 0);
+    ISA isa = isa_active();
+    kernel_variant best = candidates[0];
+    best.trial_ns = INFINITY;
+    for (uint32_t level = 0; level < ISA_COUNT; level++) {
+        ECCMethod* method = NULL;
+        for (kernel_variant& candidate : candidates) {
+            if (candidate.isa != level) {
+                continue;
+            }
+            if (method == NULL) {
+                // the isa variants are picked when a method is constructed
+                isa_force(candidate.isa);
+                method = create_method(method_name, d, k, false, compile);
+                method->SetDecodeTable(base.decode_table);
+            }
+            method->SetEncoderVariant(candidate.encoder);
+            method->SetDecoderVariant(candidate.decoder);
+            candidate.trial_ns = tune_trial_ns(base, method, candidate.engine, candidate.lanes, max_trials);
+            if (candidate.trial_ns < best.trial_ns) {
+                best = candidate;
+            }
+        }
+        delete method;
+    }
+    isa_force(isa);
+    return best;
 }
 
 void test_bit_enumeration_idx()
@@ -407,7 +985,12 @@ void test_bit_enumeration_idx()
     uint64_t r = 3;
     uint64_t calc_ncr = nCr(n, r);
     for (uint64_t idx = 0; idx < calc_ncr; idx++) {
-        if (!generated_faults.insert(bit_position_enumeration_idx_ncr(n, r, idx)).second) {
+        uint32_t positions[r];
+        bit_position_enumeration_idx_ncr<0>(n, r, idx, positions);
+        std::array<uint16_t, 8> key;
+        key.fill(UINT16_MAX);
+        std::copy(positions, positions + r, key.begin());
+        if (!generated_faults.insert(key).second) {
             errorf("duplicate insertion\n");
         }
     }
@@ -489,6 +1072,54 @@ void test_bit_enumeration_idx()
     }
 }
 
+void test_revolving_door_enumeration()
+{
+    for (uint32_t n = 1; n <= 12; n++) {
+        for (uint32_t r = 1; r <= n; r++) {
+            uint64_t calc_ncr = nCr(n, r);
+            std::unordered_set<uint64_t> generated_masks;
+            RevolvingDoorCombination walk(n, r, 0);
+            for (uint64_t idx = 0; idx < calc_ncr; idx++) {
+                if (idx > 0) {
+                    uint64_t prev_mask = 0;
+                    for (uint32_t i = 0; i < r; i++) {
+                        prev_mask |= (uint64_t)1 << walk.Positions()[i];
+                    }
+                    uint32_t out_pos;
+                    uint32_t in_pos;
+                    walk.Next(out_pos, in_pos);
+                    if ((prev_mask >> out_pos & 0b1) == 0 || (prev_mask >> in_pos & 0b1) == 1) {
+                        errorf("invalid swap\n");
+                    }
+                    prev_mask ^= ((uint64_t)1 << out_pos) | ((uint64_t)1 << in_pos);
+                    uint64_t mask = 0;
+                    for (uint32_t i = 0; i < r; i++) {
+                        mask |= (uint64_t)1 << walk.Positions()[i];
+                    }
+                    if (mask != prev_mask) {
+                        errorf("swap does not match successor\n");
+                    }
+                }
+                // unranking must land on the same combination as walking there
+                RevolvingDoorCombination unranked(n, r, idx);
+                uint64_t mask = 0;
+                for (uint32_t i = 0; i < r; i++) {
+                    if (walk.Positions()[i] >= n || (i > 0 && walk.Positions()[i] <= walk.Positions()[i - 1])) {
+                        errorf("unsorted or out of range bit idx found\n");
+                    }
+                    if (unranked.Positions()[i] != walk.Positions()[i]) {
+                        errorf("unrank mismatch\n");
+                    }
+                    mask |= (uint64_t)1 << walk.Positions()[i];
+                }
+                if (!generated_masks.insert(mask).second) {
+                    errorf("duplicate combination\n");
+                }
+            }
+        }
+    }
+}
+
 struct inject_simple_result {
     ECC_DETECTION det_result;
     uint32_t miscorrection_location;
@@ -500,7 +1131,8 @@ inject_simple_result inject_with_idx_and_get_result(ECCMethod* method, std::vect
     std::vector<bool> check_data = data;
     std::vector<bool> check_ecc = ecc;
     // inject
-    std::array<uint16_t, 8> injection_positions = bit_position_enumeration_idx_ncr(n, r, i);
+    std::vector<uint32_t> injection_positions(r);
+    bit_position_enumeration_idx_ncr<0>(n, r, i, injection_positions.data());
     for (size_t doit = 0; doit < r; doit++) {
         uint16_t pos = injection_positions[doit];
         if (pos < data.size()) {
@@ -578,6 +1210,286 @@ void test_materialization_data_independence()
     }
 }
 
+void test_syndrome_decode_equivalence()
+{
+    // the direct syndrome decoders must agree with the generic path through CheckAndCorrectPacked
+    ECCMethod_Hamming hamming;
+    ECCMethod_Hsiao hsiao(64, 8);
+    ECCMethod_BCH bch(64, 3);
+    ECCMethod_BCH bch_padded(50, 5);
+    std::vector<ECCMethod*> methods = {&hamming, &hsiao, &bch, &bch_padded};
+    for (ECCMethod* method : methods) {
+        uint32_t word_width = method->DataWidth() + method->ECCWidth();
+        std::vector<uint32_t> corrections(method->CorrectionCapability());
+        std::vector<uint32_t> expected_corrections(method->CorrectionCapability());
+        for (uint64_t injection_ctr = 0; injection_ctr < 20000; injection_ctr++) {
+            uint32_t fault_count = 1 + injection_ctr % 6;
+            ecc_syndrome syndrome;
+            ecc_syndrome power_syndrome;
+            for (uint32_t i = 0; i < fault_count; i++) {
+                uint32_t position = noise_get_u64n(injection_ctr * 8 + i, 0, word_width);
+                syndrome ^= method->ColumnSyndrome(position);
+                if (method->PowerSyndromeWidth() > 0) {
+                    power_syndrome ^= method->PowerColumn(position);
+                }
+            }
+            uint32_t count = 0;
+            uint32_t expected_count = 0;
+            ECC_DETECTION res = method->DecodeSyndrome(syndrome, corrections.data(), count);
+            ECC_DETECTION expected_res = method->ECCMethod::DecodeSyndrome(syndrome, expected_corrections.data(), expected_count);
+            if (res != expected_res) {
+                errorf("detection mismatch\n");
+            }
+            if (res == ECC_DETECTION_CORRECTED) {
+                std::sort(corrections.begin(), corrections.begin() + count);
+                std::sort(expected_corrections.begin(), expected_corrections.begin() + expected_count);
+                if (count != expected_count || !std::equal(corrections.begin(), corrections.begin() + count, expected_corrections.begin())) {
+                    errorf("correction mismatch\n");
+                }
+            }
+            if (method->PowerSyndromeWidth() == 0) {
+                continue;
+            }
+            res = method->DecodePowerSyndrome(power_syndrome, corrections.data(), count);
+            if (res != expected_res) {
+                errorf("power syndrome detection mismatch\n");
+            }
+            if (res == ECC_DETECTION_CORRECTED) {
+                std::sort(corrections.begin(), corrections.begin() + count);
+                if (count != expected_count || !std::equal(corrections.begin(), corrections.begin() + count, expected_corrections.begin())) {
+                    errorf("power syndrome correction mismatch\n");
+                }
+            }
+        }
+    }
+}
+
+void test_fixed_codes()
+{
+    // the compile time matrices must equal the runtime constructions and every encoder variant must agree on them
+    const uint32_t hsiao_configs[][2] = {{32, 7}, {64, 8}, {128, 9}, {256, 10}};
+    for (const uint32_t* config : hsiao_configs) {
+        const fixed_code* fixed = fixed_code_find(FIXED_CODE_HSIAO, config[0], config[1]);
+        if (fixed == NULL) {
+            errorf("missing fixed code\n");
+        }
+        std::vector<ecc_syndrome> columns = ECCMethod_Hsiao::ConstructColumns(config[0], config[1]);
+        for (uint32_t ci = 0; ci < columns.size(); ci++) {
+            ecc_syndrome column;
+            column.w[0] = fixed->columns[ci];
+            if (!(column == columns[ci]) || fixed->positions[fixed->columns[ci]] != ci) {
+                errorf("column mismatch\n");
+            }
+        }
+    }
+    ECCMethod_Hamming hamming;
+    ECCMethod_Hsiao hsiao_32(32, 7);
+    ECCMethod_Hsiao hsiao_64(64, 8);
+    ECCMethod_Hsiao hsiao_128(128, 9);
+    ECCMethod_Hsiao hsiao_256(256, 10);
+    std::vector<ECCMethod*> methods = {&hamming, &hsiao_32, &hsiao_64, &hsiao_128, &hsiao_256};
+    for (ECCMethod* method : methods) {
+        uint32_t word_width = method->DataWidth() + method->ECCWidth();
+        for (uint32_t ci = 0; ci < word_width; ci++) {
+            uint32_t correction;
+            uint32_t count = 0;
+            if (method->DecodeSyndrome(method->ColumnSyndrome(ci), &correction, count) != ECC_DETECTION_CORRECTED || correction != ci) {
+                errorf("position mismatch\n");
+            }
+        }
+        std::vector<uint64_t> data(ecc_packed_words(method->DataWidth()));
+        for (uint64_t data_ctr = 0; data_ctr < 10000; data_ctr++) {
+            for (uint32_t w = 0; w < data.size(); w++) {
+                data[w] = squirrelnoise5_u64(data_ctr * data.size() + w, 42);
+            }
+            ecc_syndrome expected;
+            method->SetEncoderVariant(method->EncoderVariantCount() - 1);
+            method->ConstructECCPacked(data.data(), expected.w);
+            for (uint32_t v = 0; v + 1 < method->EncoderVariantCount(); v++) {
+                ecc_syndrome ecc;
+                method->SetEncoderVariant(v);
+                method->ConstructECCPacked(data.data(), ecc.w);
+                if (!(ecc == expected)) {
+                    errorf("encoder mismatch\n");
+                }
+            }
+        }
+    }
+}
+
+void test_bch_encoder_variants()
+{
+    // every bch encoder variant must agree with the codec tables, including padded data and multi word ecc
+    const uint32_t configs[][2] = {{32, 2}, {50, 3}, {64, 3}, {100, 5}, {129, 4}, {512, 8}, {1000, 20}, {8000, 40}};
+    for (const uint32_t* config : configs) {
+        ECCMethod_BCH bch(config[0], config[1]);
+        std::vector<uint64_t> data(ecc_packed_words(bch.DataWidth()));
+        std::vector<uint64_t> expected(ecc_packed_words(bch.ECCWidth()));
+        std::vector<uint64_t> ecc(ecc_packed_words(bch.ECCWidth()));
+        for (uint64_t data_ctr = 0; data_ctr < 1000; data_ctr++) {
+            for (uint32_t w = 0; w < data.size(); w++) {
+                data[w] = squirrelnoise5_u64(data_ctr * data.size() + w, 42);
+            }
+            if (bch.DataWidth() % 64 != 0) {
+                data.back() &= ((uint64_t)1 << (bch.DataWidth() % 64)) - 1;
+            }
+            bch.SetEncoderVariant(bch.EncoderVariantCount() - 1);
+            bch.ConstructECCPacked(data.data(), expected.data());
+            for (uint32_t v = 0; v + 1 < bch.EncoderVariantCount(); v++) {
+                bch.SetEncoderVariant(v);
+                bch.ConstructECCPacked(data.data(), ecc.data());
+                if (ecc != expected) {
+                    errorf("encoder mismatch\n");
+                }
+            }
+        }
+    }
+}
+
+// random data word with its ecc and weight random flips, flips may coincide
+static void corrupted_bch_word(ECCMethod_BCH& bch, uint64_t word_ctr, uint32_t weight, std::vector<uint64_t>& data, std::vector<uint64_t>& ecc)
+{
+    uint32_t data_width = bch.DataWidth();
+    uint32_t ecc_width = bch.ECCWidth();
+    data.assign(ecc_packed_words(data_width), 0);
+    ecc.assign(ecc_packed_words(ecc_width), 0);
+    for (uint32_t w = 0; w < data.size(); w++) {
+        data[w] = squirrelnoise5_u64(word_ctr * data.size() + w, 7);
+    }
+    if (data_width % 64 != 0) {
+        data.back() &= ((uint64_t)1 << (data_width % 64)) - 1;
+    }
+    bch.ConstructECCPacked(data.data(), ecc.data());
+    for (uint32_t i = 0; i < weight; i++) {
+        uint32_t position = squirrelnoise5_u64(word_ctr * 64 + i, 8) % (data_width + ecc_width);
+        if (position < data_width) {
+            data[position / 64] ^= (uint64_t)1 << (position % 64);
+        } else {
+            ecc[(position - data_width) / 64] ^= (uint64_t)1 << ((position - data_width) % 64);
+        }
+    }
+}
+
+// both decodes of the same word must agree on the outcome, the corrections and the corrected word
+static bool same_bch_decode(ECCMethod_BCH& bch, const std::vector<uint64_t>& data, const std::vector<uint64_t>& ecc, void (*configure)(ECCMethod_BCH&, bool))
+{
+    uint32_t t = bch.CorrectionCapability();
+    std::vector<uint64_t> data_a(data), ecc_a(ecc), data_b(data), ecc_b(ecc);
+    uint32_t corrections_a[t], corrections_b[t];
+    uint32_t correction_count_a = 0, correction_count_b = 0;
+    configure(bch, false);
+    ECC_DETECTION detection_a = bch.CheckAndCorrectPacked(data_a.data(), ecc_a.data(), corrections_a, correction_count_a);
+    configure(bch, true);
+    ECC_DETECTION detection_b = bch.CheckAndCorrectPacked(data_b.data(), ecc_b.data(), corrections_b, correction_count_b);
+    std::sort(corrections_a, corrections_a + correction_count_a);
+    std::sort(corrections_b, corrections_b + correction_count_b);
+    return detection_a == detection_b && correction_count_a == correction_count_b && data_a == data_b && ecc_a == ecc_b &&
+           std::equal(corrections_a, corrections_a + correction_count_a, corrections_b);
+}
+
+void test_bch_closed_form()
+{
+    // the closed form decoders must reproduce berlekamp-massey and the root search on every error weight up to past t
+    const uint32_t configs[][2] = {{32, 1}, {32, 2}, {50, 3}, {64, 1}, {64, 2}, {64, 3}, {128, 3}, {1000, 3}};
+    for (const uint32_t* config : configs) {
+        ECCMethod_BCH bch(config[0], config[1]);
+        std::vector<uint64_t> data, ecc;
+        for (uint64_t word_ctr = 0; word_ctr < 20000; word_ctr++) {
+            corrupted_bch_word(bch, word_ctr, word_ctr % (config[1] + 3), data, ecc);
+            if (!same_bch_decode(bch, data, ecc, [](ECCMethod_BCH& bch, bool on) { bch.SetClosedForm(on); })) {
+                errorf("closed form mismatch\n");
+            }
+        }
+    }
+}
+
+void test_bch_factor_corrections()
+{
+    // past t errors the locator often does not split, a correction must still lead to a codeword of at most t distinct flips away
+    const uint32_t configs[][2] = {{64, 5}, {128, 6}, {200, 8}, {512, 16}};
+    for (const uint32_t* config : configs) {
+        ECCMethod_BCH bch(config[0], config[1]);
+        bch.SetChienSearch(false);
+        std::vector<uint64_t> data, ecc;
+        for (uint64_t word_ctr = 0; word_ctr < 20000; word_ctr++) {
+            corrupted_bch_word(bch, word_ctr, config[1] + 1 + word_ctr % 3, data, ecc);
+            uint32_t corrections[config[1]];
+            uint32_t correction_count = 0;
+            if (bch.CheckAndCorrectPacked(data.data(), ecc.data(), corrections, correction_count) != ECC_DETECTION_CORRECTED) {
+                continue;
+            }
+            std::sort(corrections, corrections + correction_count);
+            if (std::adjacent_find(corrections, corrections + correction_count) != corrections + correction_count) {
+                errorf("repeated correction\n");
+            }
+            uint32_t recheck_count = 0;
+            if (bch.CheckAndCorrectPacked(data.data(), ecc.data(), corrections, recheck_count) != ECC_DETECTION_OK) {
+                errorf("correction to a non codeword\n");
+            }
+        }
+    }
+}
+
+static const uint32_t BCH_ROOT_SEARCH_CONFIGS[][2] = {{64, 5}, {128, 6}, {200, 8}, {512, 8}, {512, 16}, {1000, 20}, {2000, 10}, {4000, 30}, {8000, 40}};
+
+void test_bch_chien_search()
+{
+    // both decoder variants, the chien search and the factorization, must find the same roots with every kernel variant, also for
+    // the locators past t errors that do not split
+    const ISA isas[] = {ISA_SCALAR, ISA_AVX2};
+    for (ISA isa : isas) {
+        if (!isa_force(isa)) {
+            continue;
+        }
+        for (const uint32_t* config : BCH_ROOT_SEARCH_CONFIGS) {
+            ECCMethod_BCH bch(config[0], config[1]);
+            std::vector<uint64_t> data, ecc;
+            for (uint64_t word_ctr = 0; word_ctr < 2000; word_ctr++) {
+                corrupted_bch_word(bch, word_ctr, config[1] - 2 + word_ctr % 5, data, ecc);
+                if (!same_bch_decode(bch, data, ecc, [](ECCMethod_BCH& bch, bool on) { bch.SetDecoderVariant(on ? 1 : 0); })) {
+                    errorf("chien search mismatch\n");
+                }
+            }
+        }
+    }
+    isa_force(isa_detect());
+}
+
+void bench_bch_root_search()
+{
+    // decode time of words with t errors, whose locators the codec factors or the chien search walks, per kernel variant
+    const ISA isas[] = {ISA_SCALAR, ISA_AVX2};
+    const uint32_t word_count = 2000;
+    for (const uint32_t* config : BCH_ROOT_SEARCH_CONFIGS) {
+        for (ISA isa : isas) {
+            if (!isa_force(isa)) {
+                continue;
+            }
+            ECCMethod_BCH bch(config[0], config[1]);
+            std::vector<std::vector<uint64_t>> words_data(word_count), words_ecc(word_count);
+            for (uint32_t wi = 0; wi < word_count; wi++) {
+                corrupted_bch_word(bch, wi, config[1], words_data[wi], words_ecc[wi]);
+            }
+            std::vector<uint64_t> data, ecc;
+            uint32_t corrections[config[1]];
+            double decode_ns[2];
+            for (uint32_t chien = 0; chien < 2; chien++) {
+                bch.SetChienSearch(chien == 1);
+                uint64_t start_ns = monotonic_ns();
+                for (uint32_t wi = 0; wi < word_count; wi++) {
+                    data = words_data[wi];
+                    ecc = words_ecc[wi];
+                    uint32_t correction_count = 0;
+                    bch.CheckAndCorrectPacked(data.data(), ecc.data(), corrections, correction_count);
+                }
+                decode_ns[chien] = (double)(monotonic_ns() - start_ns) / word_count;
+            }
+            printf("bch %u/%u %-6s factor %8.0f ns  chien %8.0f ns\n", config[0], config[1], isa_name(isa), decode_ns[0], decode_ns[1]);
+        }
+    }
+    isa_force(isa_detect());
+}
+
 int main(int argc, char** argv)
 {
     if (false) {
@@ -588,16 +1500,105 @@ int main(int argc, char** argv)
         test_materialization_data_independence();
         exit(0);
     }
+    if (false) {
+        test_syndrome_decode_equivalence();
+        exit(0);
+    }
+    if (false) {
+        test_revolving_door_enumeration();
+        exit(0);
+    }
+    if (false) {
+        test_fixed_codes();
+        exit(0);
+    }
+    if (false) {
+        test_bch_encoder_variants();
+        exit(0);
+    }
+    if (false) {
+        test_bch_closed_form();
+        exit(0);
+    }
+    if (false) {
+        test_bch_factor_corrections();
+        exit(0);
+    }
+    if (false) {
+        test_bch_chien_search();
+        exit(0);
+    }
+    if (false) {
+        bench_bch_root_search();
+        exit(0);
+    }
 
     bool full_run = false;
+    ENGINE engine = ENGINE_AUTO;
+    ANALYTIC analytic = ANALYTIC_DEFAULT;
+    uint32_t lanes = 256;
+    bool lanes_fixed = false;
+    bool compile = false;
+    bool isa_fixed = false;
     FAIL_MODE fail_mode;
     uint32_t fail_count;
-    uint64_t test_count;
+    uint128_t test_count;
     uint64_t seed = 42;
 
+    // parse options, these may be placed anywhere and are removed from the positional clas
+    std::vector<char*> positional_args;
+    for (int ai = 0; ai < argc; ai++) {
+        if (strncmp(argv[ai], "--engine=", 9) == 0) {
+            const char* arg_engine = argv[ai] + 9;
+            if (strcmp(arg_engine, "materialize") == 0) {
+                engine = ENGINE_MATERIALIZE;
+            } else if (strcmp(arg_engine, "syndrome") == 0) {
+                engine = ENGINE_SYNDROME;
+            } else if (strcmp(arg_engine, "bitsliced") == 0) {
+                engine = ENGINE_BITSLICED;
+            } else if (strcmp(arg_engine, "auto") == 0) {
+                engine = ENGINE_AUTO;
+            } else {
+                errorf("unknown engine\n");
+            }
+        } else if (strncmp(argv[ai], "--analytic=", 11) == 0) {
+            const char* arg_analytic = argv[ai] + 11;
+            if (strcmp(arg_analytic, "dp") == 0) {
+                analytic = ANALYTIC_DP;
+            } else if (strcmp(arg_analytic, "weights") == 0) {
+                analytic = ANALYTIC_WEIGHTS;
+            } else if (strcmp(arg_analytic, "mitm") == 0) {
+                analytic = ANALYTIC_MITM;
+            } else {
+                errorf("unknown analytic method\n");
+            }
+        } else if (strncmp(argv[ai], "--isa=", 6) == 0) {
+            ISA isa;
+            if (!isa_parse(argv[ai] + 6, isa)) {
+                errorf("unknown isa\n");
+            }
+            if (!isa_force(isa)) {
+                errorf("isa %s is not supported by this host\n", isa_name(isa));
+            }
+            isa_fixed = true;
+        } else if (strcmp(argv[ai], "--compile") == 0) {
+            compile = true;
+        } else if (strncmp(argv[ai], "--lanes=", 8) == 0) {
+            lanes = strtoul(argv[ai] + 8, NULL, 10);
+            if (lanes != 64 && lanes != 256 && lanes != 512) {
+                errorf("lanes must be 64, 256 or 512\n");
+            }
+            lanes_fixed = true;
+        } else {
+            positional_args.push_back(argv[ai]);
+        }
+    }
+    argc = positional_args.size();
+    argv = positional_args.data();
+
     // parse clas
     if (argc < 7) {
-        errorf("usage: <threads> <fail_mode> <fail_count> <test_count> <ecc_method> <ecc_conf> [seed]\n");
+        errorf("usage: [--engine=<auto|materialize|syndrome|bitsliced>] [--lanes=<64|256|512>] [--isa=<scalar|popcnt|avx2|avx512|gfni>] [--compile] [--analytic=<dp|weights|mitm>] <threads> <fail_mode> <fail_count> <test_count|F|A|D> <ecc_method> <ecc_conf> [seed]\n");
     }
 
     const char* arg_thread_count = argv[1];
@@ -629,8 +1630,9 @@ int main(int argc, char** argv)
     }
 
     fail_count = strtoul(arg_fail_count, NULL, 10);
-    assert(fail_count <= 8);
 
+    int ecc_d;
+    int ecc_k;
     {
         int d;
         int k;
@@ -638,79 +1640,240 @@ int main(int argc, char** argv)
         if (ec != 2) {
             errorf("failed to read ecc conf\n");
         }
-        if (strcmp(arg_ecc_method, "hamming") == 0) {
-            for (int tid = 0; tid < threads.size(); tid++) {
-                threads[tid].method = new ECCMethod_Hamming();
-            }
-        } else if (strcmp(arg_ecc_method, "bch") == 0) {
-            for (int tid = 0; tid < threads.size(); tid++) {
-                threads[tid].method = new ECCMethod_BCH(d, k);
+        for (int tid = 0; tid < threads.size(); tid++) {
+            threads[tid].method = create_method(arg_ecc_method, d, k, debug_print, compile);
+            if (threads[tid].method == NULL) {
+                errorf("unknown ecc method\n");
             }
-        } else if (strcmp(arg_ecc_method, "hsiao") == 0) {
-            for (int tid = 0; tid < threads.size(); tid++) {
-                threads[tid].method = new ECCMethod_Hsiao(d, k, debug_print);
+        }
+        if (compile && dynamic_cast<ECCMethod_Compiled*>(threads[0].method) == NULL) {
+            if (!ECCMethod_Compiled::Fits(threads[0].method)) {
+                errorf("compiled kernels need a decoder without padding and at most %u ecc bits\n", ECC_SYNDROME_MAX_BITS);
             }
-        } else {
-            errorf("unknown ecc method\n");
+            printf("compiled kernel: no working compiler, using the generic kernels\n");
+            compile = false;
         }
+        ecc_d = d;
+        ecc_k = k;
     }
 
     const uint32_t data_width = threads[0].method->DataWidth();
     const uint32_t ecc_width = threads[0].method->ECCWidth();
     const uint32_t word_width = data_width + ecc_width;
+    if (fail_mode != FAIL_MODE_NONE && fail_count > word_width) {
+        errorf("fail count exceeds the word width\n");
+    }
 
-    full_run = strcmp(arg_test_count, "F") == 0;
-    if (full_run) {
-        test_count = nCr(word_width, fail_count);
+    const bool depth_first_run = strcmp(arg_test_count, "D") == 0;
+    full_run = strcmp(arg_test_count, "F") == 0 || depth_first_run;
+    bool analytic_run = strcmp(arg_test_count, "A") == 0;
+    if (analytic_run && analytic == ANALYTIC_DEFAULT) {
+        if (fail_mode != FAIL_MODE_RANDOM) {
+            errorf("analytic full runs only support fail mode R\n");
+        }
+        analytic = pick_analytic(threads[0].method, fail_count);
+        if (analytic == ANALYTIC_ENUMERATE) {
+            // same results, fewer trials than the counting takes steps
+            printf("analytic: enumerating is cheaper than counting\n");
+            analytic_run = false;
+            full_run = true;
+        }
+    }
+    if (analytic_run) {
+        if (fail_mode != FAIL_MODE_RANDOM) {
+            errorf("analytic full runs only support fail mode R\n");
+        }
+        const uint32_t radius = threads[0].method->CorrectionCapability();
+        if (analytic == ANALYTIC_DP && !ECCDecodeTable::Fits(threads[0].method)) {
+            errorf("analytic dp needs a decode table, at most %u ecc bits\n", ECCDecodeTable::MAX_SYNDROME_BITS);
+        }
+        if (analytic == ANALYTIC_DP && syndrome_dp_bytes(threads[0].method, fail_count) > SYNDROME_DP_MAX_BYTES) {
+            errorf("analytic dp needs %lu MiB for its layers, at most %lu\n", syndrome_dp_bytes(threads[0].method, fail_count) >> 20, SYNDROME_DP_MAX_BYTES >> 20);
+        }
+        if (analytic != ANALYTIC_DP && !threads[0].method->BoundedDistance()) {
+            errorf("analytic weights and mitm need a bounded distance decoder\n");
+        }
+        if (analytic == ANALYTIC_WEIGHTS && !macwilliams_fits(threads[0].method, fail_count + radius)) {
+            errorf("analytic weights supports at most %u ecc bits and 128 bit transform sums\n", MACWILLIAMS_MAX_ECC_BITS);
+        }
+        if (analytic == ANALYTIC_MITM && ecc_width > MITM_MAX_SYNDROME_BITS) {
+            errorf("analytic mitm supports at most %u ecc bits\n", MITM_MAX_SYNDROME_BITS);
+        }
+        if (analytic == ANALYTIC_MITM && threads[0].method->PaddingWidth() != 0) {
+            errorf("analytic mitm does not support decoder padding\n");
+        }
+        if (nCr128(word_width, fail_count) > UINT64_MAX) {
+            errorf("too many fault combinations for 64 bit counters\n");
+        }
+        test_count = 0; // set from the results
+    } else if (depth_first_run) {
+        if (fail_mode != FAIL_MODE_RANDOM) {
+            errorf("depth first full runs only support fail mode R\n");
+        }
+        if (engine == ENGINE_AUTO) {
+            engine = ENGINE_SYNDROME;
+        }
+        if (engine != ENGINE_SYNDROME) {
+            errorf("depth first full runs need the syndrome engine\n");
+        }
+        test_count = 0;
+        for (uint32_t r = 1; r <= fail_count; r++) {
+            if (nCr128(word_width, r) == NCR_SATURATED || test_count > NCR_SATURATED - nCr128(word_width, r)) {
+                errorf("too many fault combinations for 128 bit counters\n");
+            }
+            test_count += nCr128(word_width, r);
+        }
+    } else if (full_run) {
+        test_count = fail_mode == FAIL_MODE_RANDOM_BURST ? word_width - fail_count + 1 : nCr128(word_width, fail_count);
+        if (test_count == NCR_SATURATED) {
+            errorf("too many fault combinations for 128 bit counters\n");
+        }
     } else {
-        test_count = strtoul(arg_test_count, NULL, 10);
+        test_count = strtoull(arg_test_count, NULL, 10);
     }
 
     srand(time(NULL)); // quick and dirty randomness if no seed given
     seed = arg_seed == NULL ? rand() : strtoull(arg_seed, NULL, 10);
     uint64_t rctr = 0;
 
-    const bool print_tests = !full_run && test_count <= 10;
+    const bool print_tests = !full_run && !analytic_run && test_count <= 10;
+
+    const bool syndrome_fits = ecc_width <= ECC_SYNDROME_MAX_BITS;
+    const bool bitsliced_decoder = threads[0].method->CorrectionCapability() == 1 && threads[0].method->BoundedDistance() && threads[0].method->PaddingWidth() == 0;
+    if (engine == ENGINE_SYNDROME && !syndrome_fits) {
+        errorf("syndrome engine supports at most %u ecc bits\n", ECC_SYNDROME_MAX_BITS);
+    }
+    if (engine == ENGINE_BITSLICED) {
+        if (!syndrome_fits) {
+            errorf("bitsliced engine supports at most %u ecc bits\n", ECC_SYNDROME_MAX_BITS);
+        }
+        if (!bitsliced_decoder) {
+            errorf("bitsliced engine needs a single error correcting bounded distance decoder without padding\n");
+        }
+    }
+
+    // one shared decode table, only worth building if the run does at least as many trials as the table has entries
+    ECCDecodeTable* decode_table = NULL;
+    if (ECCDecodeTable::Fits(threads[0].method) && (((uint64_t)1 << ecc_width) <= test_count || (analytic_run && analytic == ANALYTIC_DP))) {
+        std::vector<ECCMethod*> methods;
+        for (int tid = 0; tid < threads.size(); tid++) {
+            methods.push_back(threads[tid].method);
+        }
+        decode_table = new ECCDecodeTable(methods);
+        for (int tid = 0; tid < threads.size(); tid++) {
+            threads[tid].method->SetDecodeTable(decode_table);
+        }
+    }
+
+    // auto benchmarks every engine, isa, lane count, encoder and decoder variant that applies on the actual method and fail mode, the
+    // isa and lanes options pin theirs
+    size_t tune_candidate_count = 0;
+    double tuned_trial_ns = 0;
+    uint32_t encoder = 0;
+    uint32_t decoder = 0;
+    if (engine == ENGINE_AUTO && !analytic_run && !print_tests && test_count >= TUNE_MIN_TRIALS) {
+        std::vector<kernel_variant> candidates;
+        ISA isa_top = isa_fixed ? isa_active() : isa_detect();
+        uint32_t decoder_count = threads[0].method->DecoderVariantCount();
+        for (uint32_t level = isa_fixed ? isa_active() : ISA_SCALAR; level <= isa_top; level++) {
+            for (uint32_t encoder = 0; encoder < threads[0].method->EncoderVariantCount(); encoder++) {
+                for (uint32_t decoder = 0; decoder < decoder_count; decoder++) {
+                    candidates.push_back({ENGINE_MATERIALIZE, lanes, (ISA)level, encoder, decoder, 0});
+                }
+            }
+            // the bitsliced kernels only have scalar, avx2 and avx512 variants
+            if (syndrome_fits && bitsliced_decoder && (isa_fixed || level == ISA_SCALAR || level == ISA_AVX2 || level == ISA_AVX512)) {
+                for (uint32_t lane_option : {64, 256, 512}) {
+                    if (!lanes_fixed || lane_option == lanes) {
+                        candidates.push_back({ENGINE_BITSLICED, lane_option, (ISA)level, 0, 0, 0});
+                    }
+                }
+            }
+        }
+        if (syndrome_fits) {
+            for (uint32_t decoder = 0; decoder < decoder_count; decoder++) {
+                candidates.push_back({ENGINE_SYNDROME, lanes, isa_top, 0, decoder, 0});
+            }
+        }
+
+        thread_control base;
+        base.full_run = full_run;
+        base.fail_mode = fail_mode;
+        base.fail_count = fail_count;
+        base.rng_seed = seed;
+        base.decode_table = decode_table;
+        kernel_variant tuned = tune_kernel_variant(base, arg_ecc_method, ecc_d, ecc_k, compile, test_count, candidates);
+        tune_candidate_count = candidates.size();
+        tuned_trial_ns = tuned.trial_ns;
+
+        engine = tuned.engine;
+        lanes = tuned.lanes;
+        encoder = tuned.encoder;
+        decoder = tuned.decoder;
+        isa_force(tuned.isa);
+        for (int tid = 0; tid < threads.size(); tid++) {
+            delete threads[tid].method;
+            threads[tid].method = create_method(arg_ecc_method, ecc_d, ecc_k, debug_print, compile);
+            threads[tid].method->SetDecodeTable(decode_table);
+            threads[tid].method->SetEncoderVariant(encoder);
+            threads[tid].method->SetDecoderVariant(decoder);
+        }
+    } else if (engine == ENGINE_AUTO) {
+        // printed runs show the materialized words
+        engine = syndrome_fits && !print_tests ? ENGINE_SYNDROME : ENGINE_MATERIALIZE;
+    }
 
-    uint64_t work_per_thread = test_count / thread_count;
-    uint64_t rest_work = test_count % thread_count;
+    uint128_t work_per_thread = test_count / thread_count;
+    uint128_t rest_work = test_count % thread_count;
 
     // set final thread launching arguments
     for (int tid = 0; tid < threads.size(); tid++) {
         threads[tid].full_run = full_run;
         threads[tid].fail_mode = fail_mode;
         threads[tid].fail_count = fail_count;
+        threads[tid].engine = engine;
+        threads[tid].lanes = lanes;
+        threads[tid].decode_table = decode_table;
         threads[tid].rng_seed = squirrelnoise5_u64(rctr++, seed);
         threads[tid].work_offset = tid * work_per_thread;
         threads[tid].work_max = (tid + 1) * work_per_thread + (tid == threads.size() - 1 ? rest_work : 0);
+        if (depth_first_run) {
+            // every thread walks the subtrees below the roots tid, tid + thread_count, ..
+            threads[tid].work_offset = tid;
+            threads[tid].work_stride = threads.size();
+            threads[tid].work_max = 0;
+            for (uint32_t root = tid; root < word_width; root += threads.size()) {
+                for (uint32_t depth = 0; depth < fail_count; depth++) {
+                    threads[tid].work_max += nCr128(word_width - 1 - root, depth);
+                }
+            }
+        }
     }
 
     printf("datawidth: %u ; eccwidth: %u\n", data_width, ecc_width);
-    if (full_run) {
-        char testcount_str[SPACED_U64_MAX_STR_SIZE];
-        pre_format_spaced_u64(testcount_str, test_count, ' ');
-        printf("full run: %s tests\n", testcount_str);
-    }
-
-    // launch
-    for (int tid = 0; tid < threads.size(); tid++) {
-        pthread_create(&threads[tid].pthread_id, NULL, thread_work, &threads[tid]);
-    }
-
-    // report progress
-    while (true) {
-        uint64_t work_progress = 0;
-        for (int tid = 0; tid < threads.size(); tid++) {
-            work_progress += threads[tid].work_progress;
+    printf("isa: %s\n", isa_name(isa_active()));
+    if (!analytic_run) {
+        printf("engine: %s", ENGINE_NAMES[engine]);
+        if (engine == ENGINE_BITSLICED) {
+            printf(", %u lanes", lanes);
+        } else if (engine == ENGINE_MATERIALIZE && threads[0].method->EncoderVariantCount() > 1) {
+            printf(", %s encoder", threads[0].method->EncoderVariantName(encoder));
         }
-        if (!print_tests) {
-            printf("\rprogress: %.5f", (float)work_progress / (float)test_count);
-            fflush(stdout);
+        if (engine != ENGINE_BITSLICED && threads[0].method->DecoderVariantCount() > 1) {
+            printf(", %s decoder", threads[0].method->DecoderVariantName(decoder));
         }
-        if (work_progress == test_count) {
-            break;
+        if (tune_candidate_count > 0) {
+            printf(" (fastest of %zu variants, %.1f ns per trial)", tune_candidate_count, tuned_trial_ns);
         }
-        usleep(150 * 1000); // 150ms
+        printf("\n");
+    }
+    if (decode_table != NULL) {
+        printf("decode table: %lu entries\n", decode_table->Size());
+    }
+    if (full_run) {
+        char testcount_str[SPACED_U128_MAX_STR_SIZE];
+        pre_format_spaced_u128(testcount_str, test_count, ' ');
+        printf("full run: %s tests\n", testcount_str);
     }
 
     ecc_stats stats;
@@ -719,19 +1882,91 @@ int main(int argc, char** argv)
     flip_occurence_counts.resize(word_width, 0);
     flip_occurence_flip_avg_distances.resize(word_width, 0);
 
-    // collect
-    for (int tid = 0; tid < threads.size(); tid++) {
-        pthread_join(threads[tid].pthread_id, NULL);
-        stats.detection_ok += threads[tid].stats.detection_ok;
-        stats.detection_corrected += threads[tid].stats.detection_corrected;
-        stats.detection_uncorrectable += threads[tid].stats.detection_uncorrectable;
-        stats.false_corrections += threads[tid].stats.false_corrections;
-        for (int bit_pos = 0; bit_pos < word_width; bit_pos++) {
-            flip_occurence_counts[bit_pos] += threads[tid].flip_occurence_counts[bit_pos];
-            flip_occurence_flip_avg_distances[bit_pos] += threads[tid].flip_occurence_flip_avg_distances[bit_pos];
+    if (analytic_run) {
+        // count instead of enumerating, no threads needed
+        analytic_result result;
+        if (analytic == ANALYTIC_DP) {
+            syndrome_dp_full_run(threads[0].method, *decode_table, fail_count, result);
+        } else {
+            // a bounded distance decoder only needs the codewords reachable from a fault pattern by at most t corrections
+            uint32_t radius = threads[0].method->CorrectionCapability();
+            uint32_t padding_width = threads[0].method->PaddingWidth();
+            std::vector<std::vector<uint64_t>> weights;
+            if (analytic == ANALYTIC_WEIGHTS) {
+                weights = macwilliams_weight_spectrum(threads[0].method, fail_count + radius, thread_count);
+            } else {
+                weights.push_back(mitm_weight_spectrum(threads[0].method, fail_count + radius, thread_count));
+            }
+            sphere_outcomes_from_weights(word_width, padding_width, radius, fail_count, weights, result);
+        }
+        stats = result.stats;
+        flip_occurence_counts = result.flip_occurence_counts;
+        flip_occurence_flip_avg_distances = result.flip_occurence_flip_avg_distances;
+        test_count = stats.detection_ok + stats.detection_corrected + stats.detection_uncorrectable;
+        char testcount_str[SPACED_U128_MAX_STR_SIZE];
+        pre_format_spaced_u128(testcount_str, test_count, ' ');
+        printf("analytic full run: %s tests\n", testcount_str);
+    } else {
+        // launch
+        for (int tid = 0; tid < threads.size(); tid++) {
+            work_function work_fn = engine_work_function(engine, lanes);
+            if (depth_first_run) {
+                work_fn = thread_work_depth_first;
+            }
+            pthread_create(&threads[tid].pthread_id, NULL, work_fn, &threads[tid]);
         }
+
+        // report progress
+        while (true) {
+            uint128_t work_progress = 0;
+            for (int tid = 0; tid < threads.size(); tid++) {
+                work_progress += threads[tid].work_progress;
+            }
+            if (!print_tests) {
+                printf("\rprogress: %.5f", (float)work_progress / (float)test_count);
+                fflush(stdout);
+            }
+            if (work_progress == test_count) {
+                break;
+            }
+            usleep(150 * 1000); // 150ms
+        }
+
+        // collect
+        for (int tid = 0; tid < threads.size(); tid++) {
+            pthread_join(threads[tid].pthread_id, NULL);
+            stats.detection_ok += threads[tid].stats.detection_ok;
+            stats.detection_corrected += threads[tid].stats.detection_corrected;
+            stats.detection_uncorrectable += threads[tid].stats.detection_uncorrectable;
+            stats.false_corrections += threads[tid].stats.false_corrections;
+            for (int bit_pos = 0; bit_pos < word_width; bit_pos++) {
+                flip_occurence_counts[bit_pos] += threads[tid].flip_occurence_counts[bit_pos];
+                flip_occurence_flip_avg_distances[bit_pos] += threads[tid].flip_occurence_flip_avg_distances[bit_pos];
+            }
+        }
+    }
+    if (depth_first_run) {
+        printf("\rprogress: 1.00\n\n");
+        printf("stats per fail count:\n");
+        printf("fails, detection ok (sdcs), detection corrected, false corrections, detection uncorrectable\n");
+        for (uint32_t r = 1; r <= fail_count; r++) {
+            ecc_stats fail_count_stats;
+            for (int tid = 0; tid < threads.size(); tid++) {
+                fail_count_stats.detection_ok += threads[tid].fail_count_stats[r].detection_ok;
+                fail_count_stats.detection_corrected += threads[tid].fail_count_stats[r].detection_corrected;
+                fail_count_stats.false_corrections += threads[tid].fail_count_stats[r].false_corrections;
+                fail_count_stats.detection_uncorrectable += threads[tid].fail_count_stats[r].detection_uncorrectable;
+            }
+            printf("%u, %lu, %lu, %lu, %lu\n", r, fail_count_stats.detection_ok, fail_count_stats.detection_corrected, fail_count_stats.false_corrections, fail_count_stats.detection_uncorrectable);
+        }
+        printf("\n");
+        printf("done\n");
+        return 0;
     }
-    if (stats.false_corrections > 0) {
+
+    // the mitm counts do not see individual positions
+    const bool flips_tracked = !flip_occurence_counts.empty();
+    if (stats.false_corrections > 0 && flips_tracked) {
         for (int bit_pos = 0; bit_pos < word_width; bit_pos++) {
             flip_occurence_flip_avg_distances[bit_pos] /= (int64_t)fail_count * (int64_t)stats.false_corrections;
         }
@@ -740,6 +1975,8 @@ int main(int argc, char** argv)
     // report results
     if (print_tests) {
         printf("\n\n");
+    } else if (analytic_run) {
+        printf("\n");
     } else {
         printf("\rprogress: 1.00\n\n");
     }
@@ -749,18 +1986,22 @@ int main(int argc, char** argv)
     printf("detection uncorrectable: %lu\n", stats.detection_uncorrectable);
 
     printf("\n");
-    printf("post fault flip occurences:\n");
-    for (int bit_pos = 0; bit_pos < word_width; bit_pos++) {
-        printf(" %lu", flip_occurence_counts[bit_pos]);
-    }
-    printf("\n");
+    if (flips_tracked) {
+        printf("post fault flip occurences:\n");
+        for (int bit_pos = 0; bit_pos < word_width; bit_pos++) {
+            printf(" %lu", flip_occurence_counts[bit_pos]);
+        }
+        printf("\n");
 
-    printf("\n");
-    printf("flip occurence avg flip distance:\n");
-    for (int bit_pos = 0; bit_pos < word_width; bit_pos++) {
-        printf(" %ld", flip_occurence_flip_avg_distances[bit_pos]);
+        printf("\n");
+        printf("flip occurence avg flip distance:\n");
+        for (int bit_pos = 0; bit_pos < word_width; bit_pos++) {
+            printf(" %ld", flip_occurence_flip_avg_distances[bit_pos]);
+        }
+        printf("\n");
+    } else {
+        printf("post fault flip occurences: not tracked by analytic weights and mitm\n");
     }
-    printf("\n");
 
     printf("\n");
     printf("done\n");
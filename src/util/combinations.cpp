@@ -0,0 +1,138 @@
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#include "util/combinations.hpp"
+
+struct ncr_table {
+    // row n holds r = 0..n/2, the rest follows by symmetry
+    std::vector<uint64_t> row_offsets;
+    std::vector<uint128_t> values;
+
+    ncr_table()
+    {
+        row_offsets.resize(NCR_TABLE_MAX_N + 2);
+        for (uint32_t n = 0; n <= NCR_TABLE_MAX_N; n++) {
+            row_offsets[n + 1] = row_offsets[n] + n / 2 + 1;
+        }
+        values.resize(row_offsets[NCR_TABLE_MAX_N + 1]);
+        for (uint32_t n = 0; n <= NCR_TABLE_MAX_N; n++) {
+            values[row_offsets[n]] = 1;
+            for (uint32_t r = 1; r <= n / 2; r++) {
+                uint128_t left = Get(n - 1, r - 1);
+                uint128_t right = Get(n - 1, r);
+                values[row_offsets[n] + r] = left > NCR_SATURATED - right ? NCR_SATURATED : left + right;
+            }
+        }
+    }
+
+    uint128_t Get(uint32_t n, uint32_t r) const
+    {
+        if (r > n) {
+            return 0;
+        }
+        return values[row_offsets[n] + std::min(r, n - r)];
+    }
+};
+
+uint128_t nCr128(uint32_t n, uint32_t r)
+{
+    static const ncr_table table; // thread safe one time construction
+    if (n <= NCR_TABLE_MAX_N) {
+        return table.Get(n, r);
+    } else if (r > n) {
+        return 0;
+    }
+    // multiplicative, every step ends on the binomial C(n, i + 1) so (i + 1) / g divides n - i once the common factor g with ret is out
+    r = std::min(r, n - r);
+    uint128_t ret = 1;
+    for (uint32_t i = 0; i < r; i++) {
+        uint32_t g = i + 1;
+        for (uint32_t rest = ret % g; rest != 0;) {
+            uint32_t next = g % rest;
+            g = rest;
+            rest = next;
+        }
+        uint32_t factor = (n - i) / ((i + 1) / g);
+        if (ret / g > NCR_SATURATED / factor) {
+            return NCR_SATURATED;
+        }
+        ret = ret / g * factor;
+    }
+    return ret;
+}
+
+uint64_t nCr(uint32_t n, uint32_t r)
+{
+    uint128_t ret = nCr128(n, r);
+    assert(ret <= UINT64_MAX);
+    return ret;
+}
+
+RevolvingDoorCombination::RevolvingDoorCombination(uint32_t n, uint32_t r, uint128_t rank):
+    n(n),
+    r(r)
+{
+    assert(r <= n);
+    assert(rank < nCr128(n, r));
+    p.resize(r + 1);
+    p[r] = n;
+    // unrank, positions are 0 based so element i + 1 of the 1 based algorithm lives in p[i] - 1
+    int64_t x = n;
+    for (int i = r; i >= 1; i--) {
+        while (nCr128(x, i) > rank) {
+            x--;
+        }
+        p[i - 1] = x;
+        rank = nCr128(x + 1, i) - rank - 1;
+    }
+}
+
+RevolvingDoorCombination::~RevolvingDoorCombination()
+{
+    // pass
+}
+
+const uint32_t* RevolvingDoorCombination::Positions() const
+{
+    return p.data();
+}
+
+void RevolvingDoorCombination::Next(uint32_t& out_pos, uint32_t& in_pos)
+{
+    // find the end of the leading 0, 1, 2, .. run, its length is amortized constant
+    int j = 0;
+    while (j < r && p[j] == (uint32_t)j) {
+        j++;
+    }
+    if (((r - j - 1) & 0b1) != 0) {
+        if (j == 0) {
+            out_pos = p[0];
+            in_pos = --p[0];
+        } else if (j == 1) {
+            out_pos = 0;
+            in_pos = 1;
+            p[0] = 1;
+        } else {
+            out_pos = j - 2;
+            in_pos = j;
+            p[j - 1] = j;
+            p[j - 2] = j - 1;
+        }
+    } else if (p[j + 1] != p[j] + 1) {
+        if (j == 0) {
+            out_pos = p[0];
+            in_pos = ++p[0];
+        } else {
+            out_pos = j - 1;
+            p[j - 1] = p[j];
+            in_pos = ++p[j];
+        }
+    } else {
+        out_pos = p[j] + 1;
+        in_pos = j;
+        p[j + 1] = p[j];
+        p[j] = j;
+    }
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+typedef unsigned __int128 uint128_t;
+
+static const uint128_t NCR_SATURATED = ~(uint128_t)0;
+static const uint32_t NCR_TABLE_MAX_N = 1024;
+
+// C(n, r) from one pascal table shared by all threads, built on first use for n <= NCR_TABLE_MAX_N and computed on the fly beyond
+// counts that do not fit 128 bits saturate at NCR_SATURATED, r > n gives 0
+uint128_t nCr128(uint32_t n, uint32_t r);
+
+// same for counts known to fit 64 bits
+uint64_t nCr(uint32_t n, uint32_t r);
+
+class RevolvingDoorCombination {
+    // r-combinations of n positions in revolving door order (Kreher & Stinson, algorithms 2.11 - 2.13)
+    // successive combinations differ by exactly one position swapped out for another one
+
+  private:
+
+    int n;
+    int r;
+    std::vector<uint32_t> p; // sorted positions, p[r] = n is a sentinel
+
+  public:
+
+    // starts at the combination with the given rank
+    RevolvingDoorCombination(uint32_t n, uint32_t r, uint128_t rank);
+    ~RevolvingDoorCombination();
+
+    const uint32_t* Positions() const;
+
+    // steps to the successor, must not be called on the last combination
+    void Next(uint32_t& out_pos, uint32_t& in_pos);
+};
@@ -0,0 +1,57 @@
+#include <cstdint>
+#include <cstring>
+
+#include "util/isa.hpp"
+
+static const char* ISA_NAMES[ISA_COUNT] = {"scalar", "popcnt", "avx2", "avx512", "gfni"};
+
+static ISA isa_forced = ISA_COUNT; // none
+
+ISA isa_detect()
+{
+    __builtin_cpu_init();
+    if (!__builtin_cpu_supports("sse4.2") || !__builtin_cpu_supports("popcnt")) {
+        return ISA_SCALAR;
+    }
+    if (!__builtin_cpu_supports("avx2") || !__builtin_cpu_supports("pclmul")) {
+        return ISA_POPCNT;
+    }
+    if (!__builtin_cpu_supports("avx512f") || !__builtin_cpu_supports("avx512bw") || !__builtin_cpu_supports("avx512vl") || !__builtin_cpu_supports("avx512vpopcntdq")) {
+        return ISA_AVX2;
+    }
+    if (!__builtin_cpu_supports("gfni")) {
+        return ISA_AVX512;
+    }
+    return ISA_GFNI;
+}
+
+ISA isa_active()
+{
+    static const ISA detected = isa_detect();
+    return isa_forced != ISA_COUNT ? isa_forced : detected;
+}
+
+bool isa_force(ISA isa)
+{
+    if (isa > isa_detect()) {
+        return false;
+    }
+    isa_forced = isa;
+    return true;
+}
+
+const char* isa_name(ISA isa)
+{
+    return isa < ISA_COUNT ? ISA_NAMES[isa] : "unknown";
+}
+
+bool isa_parse(const char* name, ISA& isa)
+{
+    for (uint32_t i = 0; i < ISA_COUNT; i++) {
+        if (strcmp(name, ISA_NAMES[i]) == 0) {
+            isa = (ISA)i;
+            return true;
+        }
+    }
+    return false;
+}
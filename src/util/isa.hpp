@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+
+// instruction set levels with their own kernel variants, every level implies the ones below it
+enum ISA {
+    ISA_SCALAR = 0, // baseline x86-64, software popcount
+    ISA_POPCNT, // sse4.2 and popcnt
+    ISA_AVX2, // avx2 and pclmulqdq
+    ISA_AVX512, // avx512 f, bw, vl and vpopcntdq
+    ISA_GFNI, // avx512 with gfni affine bit matrix multiplies
+    ISA_COUNT,
+};
+
+// attributes for the kernel variants, the generic kernel bodies are always_inline so they get compiled for every variant
+#define ISA_TARGET_POPCNT __attribute__((target("sse4.2,popcnt")))
+#define ISA_TARGET_AVX2 __attribute__((target("sse4.2,popcnt,avx2,pclmul")))
+#define ISA_TARGET_AVX512 __attribute__((target("sse4.2,popcnt,avx2,pclmul,avx512f,avx512bw,avx512vl,avx512vpopcntdq")))
+#define ISA_TARGET_GFNI __attribute__((target("sse4.2,popcnt,avx2,pclmul,avx512f,avx512bw,avx512vl,avx512vpopcntdq,gfni")))
+#define ISA_INLINE inline __attribute__((always_inline))
+
+// highest level supported by the host, from cpuid
+ISA isa_detect();
+
+// level the kernels dispatch on, the detected one unless forced by isa_force
+ISA isa_active();
+
+// returns false if the host does not support the level
+bool isa_force(ISA isa);
+
+const char* isa_name(ISA isa);
+
+// parses a level name as printed by isa_name, returns false if unknown
+bool isa_parse(const char* name, ISA& isa);